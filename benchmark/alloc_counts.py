@@ -0,0 +1,93 @@
+#!/usr/bin/env python3
+"""Compare allocation counts of interpreter builds on the same program.
+
+Runs each binary with --stats and prints the per-category allocation
+requests and malloc calls it reports, side by side. Without a program the
+built-in bignum workload below is used: factorials, Fibonacci pairs and
+modular sums that pass big ints through calls, tuples and assignments.
+
+    benchmark/alloc_counts.py --binary old/code --binary build/code
+    benchmark/alloc_counts.py --binary build/code testcases/bigint-testcases/BigIntegerTest3.in
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+BIGNUM_WORKLOAD = """
+def fact(n):
+    r = 1
+    i = 2
+    while i <= n:
+        r = r * i
+        i += 1
+    return r
+
+def fib_pair(n):
+    a = 0
+    b = 1
+    while n > 0:
+        a, b = b, a + b
+        n -= 1
+    return a, b
+
+total = 0
+k = 0
+while k < 40:
+    f = fact(200 + k)
+    x, y = fib_pair(300 + k)
+    total = total + f % 1000000007 + (x * y) // (y - x)
+    k += 1
+print(total % 998244353)
+"""
+
+
+def run_stats(binary, program):
+    """Returns ({category: (requests, mallocs)}, execute-phase mallocs)."""
+    proc = subprocess.run([binary, "--stats"], input=program, capture_output=True, check=True)
+    categories = {}
+    execute = None
+    for line in proc.stderr.decode().splitlines():
+        fields = line.split()
+        if len(fields) == 5 and re.fullmatch(r"\d+", fields[1]) and fields[0] != "phase":
+            categories[fields[0]] = (int(fields[1]), int(fields[2]))
+        elif len(fields) == 4 and fields[0] == "execute":
+            execute = int(fields[2])
+    return categories, execute
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--binary", action="append",
+                        help="interpreter build; repeat to compare (default: ./code)")
+    parser.add_argument("program", nargs="?", help="program to run (default: built-in bignum workload)")
+    args = parser.parse_args()
+
+    binaries = args.binary or [os.path.join(ROOT, "code")]
+    if args.program:
+        with open(args.program, "rb") as program_file:
+            program = program_file.read()
+    else:
+        program = BIGNUM_WORKLOAD.lstrip().encode()
+
+    results = [run_stats(binary, program) for binary in binaries]
+    print(f"{'category':<10}" + "".join(f" {'requests':>12} {'mallocs':>10}" for _ in binaries))
+    for category in results[0][0]:
+        row = f"{category:<10}"
+        for categories, _ in results:
+            requests, mallocs = categories.get(category, (0, 0))
+            row += f" {requests:>12} {mallocs:>10}"
+        print(row)
+    print(f"{'execute':<10}" + "".join(f" {'':>12} {execute:>10}" for _, execute in results))
+    for index, binary in enumerate(binaries):
+        print(f"[{index}] {binary}")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,34 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_BENCH_UTIL_H
+#define PYTHON_INTERPRETER_BENCH_UTIL_H
+
+#include <chrono>
+#include <cstddef>
+
+namespace bench {
+
+struct Timing {
+    size_t calls;
+    double secondsPerCall;
+};
+
+// Call op until at least minSeconds have passed (once at minimum)
+template <typename Op>
+Timing timePerCall(Op op, double minSeconds = 0.2) {
+    using Clock = std::chrono::steady_clock;
+    size_t calls = 0;
+    size_t batch = 1;
+    auto start = Clock::now();
+    double elapsed = 0;
+    do {
+        for (size_t i = 0; i < batch; i++) op();
+        calls += batch;
+        batch = batch < 1024 ? batch * 2 : batch;
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    } while (elapsed < minSeconds);
+    return {calls, elapsed / calls};
+}
+
+}  // namespace bench
+
+#endif//PYTHON_INTERPRETER_BENCH_UTIL_H
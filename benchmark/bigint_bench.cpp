@@ -0,0 +1,87 @@
+// BigInteger microbenchmarks across operand sizes.
+// Build with `cmake --build <dir> --target bigint_bench`. Prints one JSON
+// object per line so runs can be diffed or loaded by scripts:
+//   {"op": "mul", "digits": 1000, "calls": 5120, "ns_per_op": 39000.1, "digits_per_s": 5.1e7}
+// digits is the size of each operand; digits_per_s counts input digits.
+//
+//   --max-digits N   skip sizes above N (default 1000000)
+//   --min-time S     seconds to spend per measurement (default 0.2)
+//   --threads N      threads for large multiplications (default 1)
+#include "BigInteger.h"
+#include "bench_util.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+
+namespace {
+
+std::string randomDigits(size_t digits, std::mt19937& rng) {
+    std::uniform_int_distribution<int> dist(0, 9);
+    std::string result(digits, '0');
+    for (auto& c : result) c = char('0' + dist(rng));
+    result[0] = char('1' + dist(rng) % 9);
+    return result;
+}
+
+void report(const char* op, size_t digits, double inputDigits, const bench::Timing& timing) {
+    std::printf("{\"op\": \"%s\", \"digits\": %zu, \"calls\": %zu, \"ns_per_op\": %.1f, \"digits_per_s\": %.4g}\n",
+                op, digits, timing.calls, timing.secondsPerCall * 1e9, inputDigits / timing.secondsPerCall);
+    std::fflush(stdout);
+}
+
+volatile bool sink;
+
+}  // namespace
+
+int main(int argc, const char* argv[]) {
+    size_t maxDigits = 1000000;
+    double minTime = 0.2;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (std::strcmp(argv[i], "--max-digits") == 0) {
+            maxDigits = std::strtoull(argv[i + 1], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--min-time") == 0) {
+            minTime = std::strtod(argv[i + 1], nullptr);
+        } else if (std::strcmp(argv[i], "--threads") == 0) {
+            BigInteger::setThreadCount(std::strtoull(argv[i + 1], nullptr, 10));
+        } else {
+            std::fprintf(stderr, "unknown argument: %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    std::mt19937 rng(2515);
+    for (size_t digits = 1; digits <= maxDigits; digits *= 10) {
+        std::string textA = randomDigits(digits, rng);
+        std::string textB = randomDigits(digits, rng);
+        BigInteger a(textA), b(textB);
+        // Division takes a divisor half the dividend's size
+        BigInteger divisor(randomDigits(std::max<size_t>(1, digits / 2), rng));
+
+        report("from_string", digits, digits,
+               bench::timePerCall([&] { sink = BigInteger(textA).isZero(); }, minTime));
+        report("to_string", digits, digits,
+               bench::timePerCall([&] { sink = a.toString().empty(); }, minTime));
+        report("add", digits, 2.0 * digits,
+               bench::timePerCall([&] { sink = (a + b).isZero(); }, minTime));
+        report("sub", digits, 2.0 * digits,
+               bench::timePerCall([&] { sink = (a - b).isZero(); }, minTime));
+        report("add_inplace", digits, 2.0 * digits, bench::timePerCall([&] {
+            BigInteger sum = a;
+            sum += b;
+            sink = sum.isZero();
+        }, minTime));
+        report("mul", digits, 2.0 * digits,
+               bench::timePerCall([&] { sink = (a * b).isZero(); }, minTime));
+        report("div", digits, 1.5 * digits,
+               bench::timePerCall([&] { sink = (a / divisor).isZero(); }, minTime));
+        report("mod", digits, 1.5 * digits,
+               bench::timePerCall([&] { sink = (a % divisor).isZero(); }, minTime));
+        report("mod_word", digits, digits, bench::timePerCall([&] {
+            BigInteger quotient = a;
+            sink = quotient.divmodWord(1000000007) == 0;
+        }, minTime));
+    }
+    return 0;
+}
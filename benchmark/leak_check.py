@@ -0,0 +1,100 @@
+#!/usr/bin/env python3
+"""Check that the interpreter's live memory stays flat in long loops.
+
+Runs each workload below with --stats at two sizes, n and 2n iterations,
+and compares the peak live bytes it reports. A loop that leaks a little
+per iteration peaks about twice as high at 2n; one that does not peaks at
+the same level whatever the size. Exits with status 1 when some workload
+grows by more than --slack.
+
+    benchmark/leak_check.py --binary build/code
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Each runs its body N times, with the interpreter flags given: every
+# builtin, the instructions that build strings and tuples, and profiled
+# calls that the memo cache answers or that find no function
+WORKLOADS = {
+    "builtins": ([], """
+i = 0
+while i < N:
+    s = str(i)
+    x = int(s) + 1
+    f = float(x)
+    b = bool(i)
+    print(i, s)
+    i += 1
+"""),
+    "strings": ([], """
+def pair(a):
+    return a, a + 1
+
+i = 0
+while i < N:
+    text = f"{i} and {i + 1}"
+    p = pair(i)
+    i += 1
+print(text, p)
+"""),
+    "memoized": (["--memoize", "--profile"], """
+def square(a):
+    return a * a
+
+i = 0
+while i < N:
+    x = square(i % 10)
+    i += 1
+print(x)
+"""),
+    "unresolved": (["--profile"], """
+name = "missing"
+i = 0
+while i < N:
+    x = name(i)
+    i += 1
+print(x)
+"""),
+}
+
+
+def peak_live(binary, flags, program):
+    """Peak live bytes of all categories, as --stats reports them."""
+    proc = subprocess.run([binary, "--stats"] + flags, input=program.encode(),
+                          stdout=subprocess.DEVNULL, stderr=subprocess.PIPE, check=True)
+    for line in proc.stderr.decode().splitlines():
+        fields = line.split()
+        if len(fields) == 5 and fields[0] == "total" and re.fullmatch(r"\d+", fields[4]):
+            return int(fields[4])
+    raise RuntimeError("no memory report from " + binary)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--binary", default=os.path.join(ROOT, "code"),
+                        help="interpreter executable (default: ./code)")
+    parser.add_argument("--iterations", type=int, default=200000, help="n (default 200000)")
+    parser.add_argument("--slack", type=int, default=256 * 1024,
+                        help="peak live growth from n to 2n tolerated, bytes (default 256 KiB)")
+    args = parser.parse_args()
+
+    failures = 0
+    print(f"{'workload':<12} {'peak at n':>12} {'peak at 2n':>12}  result")
+    for name, (flags, body) in WORKLOADS.items():
+        peaks = [peak_live(args.binary, flags, body.replace("N", str(n)).lstrip())
+                 for n in (args.iterations, 2 * args.iterations)]
+        leaking = peaks[1] - peaks[0] > args.slack
+        failures += leaking
+        print(f"{name:<12} {peaks[0]:>12} {peaks[1]:>12}  {'GROWS' if leaking else 'flat'}")
+    return 1 if failures else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,65 @@
+// Throughput of the limb add/sub/compare kernels, scalar against AVX2.
+// Build with `cmake --build <dir> --target limb_bench` and run without
+// arguments; prints one tab-separated row per kernel, operation and size.
+#include "LimbKernels.h"
+#include "bench_util.h"
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace {
+
+std::vector<uint32_t> randomLimbs(size_t n, std::mt19937& rng) {
+    std::uniform_int_distribution<uint32_t> dist(0, limb::BASE - 1);
+    std::vector<uint32_t> limbs(n);
+    for (auto& value : limbs) value = dist(rng);
+    return limbs;
+}
+
+volatile uint32_t sink;
+
+}  // namespace
+
+int main() {
+    std::mt19937 rng(2515);
+    std::vector<const limb::Kernels*> kernelSets = {&limb::scalarKernels()};
+    if (limb::avx2Kernels()) kernelSets.push_back(limb::avx2Kernels());
+
+    std::printf("kernel\top\tlimbs\tns_per_call\tgb_per_s\n");
+    for (size_t n : {16, 256, 4096, 65536, 1048576}) {
+        auto a = randomLimbs(n, rng);
+        auto b = randomLimbs(n, rng);
+        std::vector<uint32_t> sum(n), diff(n);
+
+        for (const limb::Kernels* kernels : kernelSets) {
+            // Two limb arrays read and one written per add or sub
+            double addTime = bench::timePerCall([&] { sink = kernels->add(sum.data(), a.data(), b.data(), n); }).secondsPerCall;
+            double subTime = bench::timePerCall([&] { sink = kernels->sub(diff.data(), a.data(), b.data(), n); }).secondsPerCall;
+            // Equal operands force the comparison to scan every limb
+            double cmpTime = bench::timePerCall([&] { sink = kernels->compare(a.data(), a.data(), n); }).secondsPerCall;
+
+            double bytes = 4.0 * n;
+            std::printf("%s\tadd\t%zu\t%.1f\t%.2f\n", kernels->name, n, addTime * 1e9, 3 * bytes / addTime / 1e9);
+            std::printf("%s\tsub\t%zu\t%.1f\t%.2f\n", kernels->name, n, subTime * 1e9, 3 * bytes / subTime / 1e9);
+            std::printf("%s\tcompare\t%zu\t%.1f\t%.2f\n", kernels->name, n, cmpTime * 1e9, 2 * bytes / cmpTime / 1e9);
+        }
+
+        // Every kernel set must agree with the scalar reference
+        std::vector<uint32_t> expected(n), actual(n);
+        uint32_t expectedCarry = limb::scalarKernels().add(expected.data(), a.data(), b.data(), n);
+        for (const limb::Kernels* kernels : kernelSets) {
+            if (kernels->add(actual.data(), a.data(), b.data(), n) != expectedCarry || actual != expected) {
+                std::fprintf(stderr, "%s add disagrees with scalar at %zu limbs\n", kernels->name, n);
+                return 1;
+            }
+        }
+        uint32_t expectedBorrow = limb::scalarKernels().sub(expected.data(), a.data(), b.data(), n);
+        for (const limb::Kernels* kernels : kernelSets) {
+            if (kernels->sub(actual.data(), a.data(), b.data(), n) != expectedBorrow || actual != expected) {
+                std::fprintf(stderr, "%s sub disagrees with scalar at %zu limbs\n", kernels->name, n);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
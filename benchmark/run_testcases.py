@@ -0,0 +1,147 @@
+#!/usr/bin/env python3
+"""Time the interpreter on every testcase and compare against a baseline.
+
+Runs each ``.in`` file under ``testcases/`` through the interpreter
+``--repeat`` times, checks the output against the matching ``.out`` and
+records the median wall time, user and system CPU time and peak RSS.
+
+    # record a baseline
+    benchmark/run_testcases.py --binary build/code --save-baseline base.json
+    # later: compare, exit status 1 on regressions or wrong output
+    benchmark/run_testcases.py --binary build/code --baseline base.json
+
+A case regresses when its median wall time or peak RSS grows by more than
+``--threshold`` over the baseline (and the time by more than ``--noise``
+seconds, so millisecond cases do not flap). Cases over the OJ limits
+(16 s, 512 MiB by default) are flagged as well.
+"""
+
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import threading
+import time
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+def find_cases(directory, pattern):
+    cases = []
+    for dirpath, _, filenames in os.walk(directory):
+        for filename in filenames:
+            if filename.endswith(".in") and pattern in filename:
+                path = os.path.join(dirpath, filename)
+                cases.append(os.path.relpath(path, directory)[:-len(".in")])
+    return sorted(cases)
+
+
+def run_once(command, input_path, timeout):
+    """Run one case; returns (output, wall seconds, rusage, exit status)."""
+    with open(input_path, "rb") as stdin:
+        start = time.perf_counter()
+        proc = subprocess.Popen(command, stdin=stdin, stdout=subprocess.PIPE,
+                                stderr=subprocess.DEVNULL)
+        watchdog = threading.Timer(timeout, proc.kill)
+        watchdog.start()
+        output = proc.stdout.read()
+        _, status, usage = os.wait4(proc.pid, 0)
+        wall = time.perf_counter() - start
+        watchdog.cancel()
+        proc.stdout.close()
+        proc.returncode = os.waitstatus_to_exitcode(status)
+    return output, wall, usage, proc.returncode
+
+
+def measure(command, directory, case, repeat, timeout):
+    with open(os.path.join(directory, case + ".out"), "rb") as expected_file:
+        expected = expected_file.read()
+
+    walls, users, systems, rss = [], [], [], []
+    correct = True
+    status = 0
+    for _ in range(repeat):
+        output, wall, usage, status = run_once(command, os.path.join(directory, case + ".in"), timeout)
+        correct = correct and status == 0 and output == expected
+        walls.append(wall)
+        users.append(usage.ru_utime)
+        systems.append(usage.ru_stime)
+        rss.append(usage.ru_maxrss)  # KiB on Linux
+    return {
+        "wall": statistics.median(walls),
+        "user": statistics.median(users),
+        "sys": statistics.median(systems),
+        "rss_kib": max(rss),
+        "correct": correct,
+        "status": status,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--binary", default=os.path.join(ROOT, "code"),
+                        help="interpreter executable (default: ./code)")
+    parser.add_argument("--args", default="", help="extra arguments for the interpreter")
+    parser.add_argument("--testcases", default=os.path.join(ROOT, "testcases"),
+                        help="directory searched recursively for .in/.out pairs")
+    parser.add_argument("--filter", default="", help="only run cases whose file name contains this")
+    parser.add_argument("--repeat", type=int, default=3, help="runs per case; the median is kept")
+    parser.add_argument("--baseline", help="baseline JSON to compare against")
+    parser.add_argument("--save-baseline", help="write this run's results as a baseline")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="relative growth that counts as a regression (default 0.10)")
+    parser.add_argument("--noise", type=float, default=0.005,
+                        help="absolute wall time growth ignored as noise, seconds (default 0.005)")
+    parser.add_argument("--time-limit", type=float, default=16.0, help="seconds (default 16)")
+    parser.add_argument("--memory-limit", type=float, default=512.0, help="MiB (default 512)")
+    args = parser.parse_args()
+
+    command = [args.binary] + args.args.split()
+    baseline = {}
+    if args.baseline:
+        with open(args.baseline) as baseline_file:
+            baseline = json.load(baseline_file)["cases"]
+
+    results = {}
+    problems = 0
+    print(f"{'case':<44} {'wall s':>8} {'user s':>8} {'sys s':>7} {'rss MiB':>8}  notes")
+    for case in find_cases(args.testcases, args.filter):
+        result = measure(command, args.testcases, case, args.repeat, args.time_limit * 2)
+        results[case] = result
+
+        flags = []
+        if not result["correct"]:
+            flags.append("WRONG OUTPUT" if result["status"] == 0 else f"EXIT {result['status']}")
+        if result["wall"] > args.time_limit:
+            flags.append("OVER TIME LIMIT")
+        if result["rss_kib"] / 1024 > args.memory_limit:
+            flags.append("OVER MEMORY LIMIT")
+        notes = []
+        old = baseline.get(case)
+        if old:
+            change = result["wall"] / old["wall"] - 1 if old["wall"] > 0 else 0.0
+            notes.append(f"{change:+.1%} time")
+            if change > args.threshold and result["wall"] - old["wall"] > args.noise:
+                flags.append("TIME REGRESSION")
+            if result["rss_kib"] > old["rss_kib"] * (1 + args.threshold):
+                flags.append("MEMORY REGRESSION")
+        problems += bool(flags)
+
+        print(f"{case:<44} {result['wall']:8.3f} {result['user']:8.3f} {result['sys']:7.3f} "
+              f"{result['rss_kib'] / 1024:8.1f}  {', '.join(flags + notes)}")
+
+    total = sum(result["wall"] for result in results.values())
+    print(f"{len(results)} cases, {total:.3f} s total wall time, {problems} flagged")
+
+    if args.save_baseline:
+        with open(args.save_baseline, "w") as baseline_file:
+            json.dump({"binary": args.binary, "args": args.args, "cases": results},
+                      baseline_file, indent=1, sort_keys=True)
+    return 1 if problems else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,487 @@
+#include "BigInteger.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+// Multiply a limb vector in place by a word below BASE
+void multiplyByWord(LimbVector& limbs, uint32_t factor) {
+    uint64_t carry = 0;
+    for (auto& value : limbs) {
+        uint64_t cur = (uint64_t)value * factor + carry;
+        value = (uint32_t)(cur % limb::BASE);
+        carry = cur / limb::BASE;
+    }
+    if (carry) {
+        limbs.push_back((uint32_t)carry);
+    }
+}
+
+void trim(LimbVector& limbs) {
+    while (limbs.size() > 1 && limbs.back() == 0) {
+        limbs.pop_back();
+    }
+}
+
+// dst[offset..] += src; dst must be long enough to absorb the final carry
+void addAt(LimbVector& dst, size_t offset, const LimbVector& src) {
+    uint32_t carry = limb::add(&dst[offset], &dst[offset], src.data(), src.size());
+    for (size_t i = offset + src.size(); carry; i++) {
+        carry = ++dst[i] == limb::BASE;
+        if (carry) dst[i] = 0;
+    }
+}
+
+// dst -= src, requires dst >= src
+void subtractFrom(LimbVector& dst, const LimbVector& src) {
+    uint32_t borrow = limb::sub(dst.data(), dst.data(), src.data(), src.size());
+    for (size_t i = src.size(); borrow; i++) {
+        borrow = dst[i] == 0;
+        dst[i] = borrow ? limb::BASE - 1 : dst[i] - 1;
+    }
+}
+
+// a[0..n) + b[0..m) with n >= m
+LimbVector addSpans(const uint32_t* a, size_t n, const uint32_t* b, size_t m) {
+    LimbVector sum(a, a + n);
+    sum.push_back(0);
+    uint32_t carry = limb::add(sum.data(), sum.data(), b, m);
+    for (size_t i = m; carry; i++) {
+        carry = ++sum[i] == limb::BASE;
+        if (carry) sum[i] = 0;
+    }
+    trim(sum);
+    return sum;
+}
+
+std::unique_ptr<ThreadPool> multiplyPool;
+// Karatsuba levels that may still fork: enough for 3^depth >= threads
+int parallelDepth = 0;
+
+LimbVector multiplySchoolbook(const uint32_t* a, size_t n, const uint32_t* b, size_t m) {
+    LimbVector result(n + m, 0);
+    for (size_t i = 0; i < n; i++) {
+        uint64_t d = a[i];
+        if (d == 0) continue;
+        uint64_t carry = 0;
+        for (size_t j = 0; j < m; j++) {
+            uint64_t cur = result[i + j] + d * b[j] + carry;
+            result[i + j] = (uint32_t)(cur % limb::BASE);
+            carry = cur / limb::BASE;
+        }
+        result[i + m] = (uint32_t)carry;
+    }
+    trim(result);
+    return result;
+}
+
+// Product of two magnitudes, n >= m; the result is trimmed
+LimbVector multiplyKaratsuba(const uint32_t* a, size_t n, const uint32_t* b, size_t m, int depth) {
+    if (m < BigInteger::KARATSUBA_THRESHOLD) {
+        return multiplySchoolbook(a, n, b, m);
+    }
+
+    LimbVector result(n + m, 0);
+    if (m <= (n + 1) / 2) {
+        // Unbalanced: multiply b by m-limb slices of a
+        for (size_t offset = 0; offset < n; offset += m) {
+            size_t piece = std::min(m, n - offset);
+            auto product = piece >= m ? multiplyKaratsuba(a + offset, piece, b, m, depth)
+                                      : multiplyKaratsuba(b, m, a + offset, piece, depth);
+            addAt(result, offset, product);
+        }
+        trim(result);
+        return result;
+    }
+
+    // a = a1 * B^h + a0, b = b1 * B^h + b0, with b1 non-empty since m > h
+    size_t h = (n + 1) / 2;
+    LimbVector low, high, middle;
+    auto computeLow = [&] { low = multiplyKaratsuba(a, h, b, h, depth - 1); };
+    auto computeHigh = [&] {
+        high = n - h >= m - h ? multiplyKaratsuba(a + h, n - h, b + h, m - h, depth - 1)
+                              : multiplyKaratsuba(b + h, m - h, a + h, n - h, depth - 1);
+    };
+    auto computeMiddle = [&] {
+        auto sumA = addSpans(a, h, a + h, n - h);
+        auto sumB = addSpans(b, h, b + h, m - h);
+        middle = sumA.size() >= sumB.size()
+            ? multiplyKaratsuba(sumA.data(), sumA.size(), sumB.data(), sumB.size(), depth - 1)
+            : multiplyKaratsuba(sumB.data(), sumB.size(), sumA.data(), sumA.size(), depth - 1);
+    };
+
+    if (depth > 0 && multiplyPool && m >= BigInteger::PARALLEL_THRESHOLD) {
+        std::vector<std::function<void()>> tasks = {computeMiddle, computeLow, computeHigh};
+        multiplyPool->invokeAll(tasks);
+    } else {
+        computeLow();
+        computeHigh();
+        computeMiddle();
+    }
+
+    // middle = (a0 + a1)(b0 + b1) - low - high = a0 b1 + a1 b0
+    subtractFrom(middle, low);
+    subtractFrom(middle, high);
+    trim(middle);
+
+    addAt(result, 0, low);
+    addAt(result, h, middle);
+    addAt(result, 2 * h, high);
+    trim(result);
+    return result;
+}
+
+int decimalDigits(uint32_t value) {
+    int count = 1;
+    while (value >= 10) {
+        value /= 10;
+        count++;
+    }
+    return count;
+}
+
+}  // namespace
+
+BigInteger::BigInteger(long long num) : negative(num < 0) {
+    unsigned long long magnitude = num < 0 ? 0ULL - (unsigned long long)num : (unsigned long long)num;
+    do {
+        limbs.push_back((uint32_t)(magnitude % limb::BASE));
+        magnitude /= limb::BASE;
+    } while (magnitude > 0);
+}
+
+BigInteger& BigInteger::assign(long long num) {
+    negative = num < 0;
+    unsigned long long magnitude = num < 0 ? 0ULL - (unsigned long long)num : (unsigned long long)num;
+    limbs.clear();
+    do {
+        limbs.push_back((uint32_t)(magnitude % limb::BASE));
+        magnitude /= limb::BASE;
+    } while (magnitude > 0);
+    return *this;
+}
+
+BigInteger::BigInteger(const std::string& str) : negative(false) {
+    size_t start = 0;
+    if (!str.empty() && (str[0] == '-' || str[0] == '+')) {
+        negative = str[0] == '-';
+        start = 1;
+    }
+
+    // Nine decimal digits per limb, starting from the least significant end
+    for (size_t end = str.length(); end > start;) {
+        size_t begin = end >= start + 9 ? end - 9 : start;
+        uint32_t value = 0;
+        for (size_t i = begin; i < end; i++) {
+            value = value * 10 + (str[i] - '0');
+        }
+        limbs.push_back(value);
+        end = begin;
+    }
+    if (limbs.empty()) {
+        limbs.push_back(0);
+    }
+    removeLeadingZeros();
+}
+
+std::string BigInteger::toString() const {
+    std::string result;
+    result.reserve(limbs.size() * 9 + 1);
+    if (negative) result += '-';
+    result += std::to_string(limbs.back());
+
+    char buffer[9];
+    for (size_t i = limbs.size() - 1; i-- > 0;) {
+        uint32_t value = limbs[i];
+        for (int j = 8; j >= 0; j--) {
+            buffer[j] = char('0' + value % 10);
+            value /= 10;
+        }
+        result.append(buffer, 9);
+    }
+    return result;
+}
+
+void BigInteger::addMagnitude(const BigInteger& other) {
+    size_t n = other.limbs.size();
+    if (limbs.size() < n) {
+        limbs.resize(n, 0);
+    }
+
+    uint32_t carry = limb::add(limbs.data(), limbs.data(), other.limbs.data(), n);
+    for (size_t i = n; carry && i < limbs.size(); i++) {
+        carry = ++limbs[i] == limb::BASE;
+        if (carry) limbs[i] = 0;
+    }
+    if (carry) {
+        limbs.push_back(1);
+    }
+}
+
+void BigInteger::subMagnitude(const BigInteger& other) {
+    size_t n = other.limbs.size();
+    uint32_t borrow = limb::sub(limbs.data(), limbs.data(), other.limbs.data(), n);
+    for (size_t i = n; borrow; i++) {
+        borrow = limbs[i] == 0;
+        limbs[i] = borrow ? limb::BASE - 1 : limbs[i] - 1;
+    }
+    removeLeadingZeros();
+}
+
+void BigInteger::reverseSubMagnitude(const BigInteger& other) {
+    size_t n = other.limbs.size();
+    limbs.resize(n, 0);
+    limb::sub(limbs.data(), other.limbs.data(), limbs.data(), n);
+    removeLeadingZeros();
+}
+
+BigInteger& BigInteger::addSigned(const BigInteger& other, bool otherNegative) {
+    if (negative == otherNegative) {
+        addMagnitude(other);
+    } else if (!absLess(other)) {
+        subMagnitude(other);
+    } else {
+        reverseSubMagnitude(other);
+        negative = otherNegative;
+    }
+    removeLeadingZeros();
+    return *this;
+}
+
+void BigInteger::setThreadCount(size_t threads) {
+    multiplyPool.reset();
+    parallelDepth = 0;
+    if (threads > 1) {
+        multiplyPool = std::make_unique<ThreadPool>(threads);
+        for (size_t tasks = 1; tasks < threads; tasks *= 3) {
+            parallelDepth++;
+        }
+    }
+}
+
+BigInteger& BigInteger::operator*=(const BigInteger& other) {
+    if (&other == this) {
+        BigInteger copy(other);
+        return *this *= copy;
+    }
+
+    size_t n = limbs.size();
+    size_t m = other.limbs.size();
+    if (std::min(n, m) >= KARATSUBA_THRESHOLD) {
+        limbs = n >= m ? multiplyKaratsuba(limbs.data(), n, other.limbs.data(), m, parallelDepth)
+                       : multiplyKaratsuba(other.limbs.data(), m, limbs.data(), n, parallelDepth);
+        negative = negative != other.negative;
+        removeLeadingZeros();
+        return *this;
+    }
+
+    limbs.resize(n + m, 0);
+
+    // Walk our limbs from the top: each partial product only lands on
+    // positions whose original limb has already been consumed.
+    for (size_t i = n; i-- > 0;) {
+        uint64_t d = limbs[i];
+        limbs[i] = 0;
+        if (d == 0) continue;
+
+        uint64_t carry = 0;
+        for (size_t j = 0; j < m; j++) {
+            uint64_t cur = limbs[i + j] + d * other.limbs[j] + carry;
+            limbs[i + j] = (uint32_t)(cur % limb::BASE);
+            carry = cur / limb::BASE;
+        }
+        for (size_t k = i + m; carry; k++) {
+            uint64_t cur = limbs[k] + carry;
+            limbs[k] = (uint32_t)(cur % limb::BASE);
+            carry = cur / limb::BASE;
+        }
+    }
+
+    negative = negative != other.negative;
+    removeLeadingZeros();
+    return *this;
+}
+
+unsigned int BigInteger::divmodWord(unsigned int divisor) {
+    // floor((2^64 - 1) / divisor) stands in for a hardware divide per limb;
+    // its estimates are low by at most one while the partial dividend stays
+    // below 2^62, which holds because it is below divisor * BASE.
+    uint64_t reciprocal = ~0ULL / divisor;
+    uint64_t remainder = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        uint64_t cur = remainder * limb::BASE + limbs[i];
+        uint64_t quotient = (uint64_t)(((unsigned __int128)cur * reciprocal) >> 64);
+        remainder = cur - quotient * divisor;
+        if (remainder >= divisor) {
+            quotient++;
+            remainder -= divisor;
+        }
+        limbs[i] = (uint32_t)quotient;
+    }
+    removeLeadingZeros();
+    return (unsigned int)remainder;
+}
+
+BigInteger& BigInteger::divmod_inplace(const BigInteger& divisor, BigInteger& remainder) {
+    if (divisor.isZero()) {
+        throw std::runtime_error("Division by zero");
+    }
+    if (&divisor == this || &divisor == &remainder) {
+        BigInteger copy(divisor);
+        return divmod_inplace(copy, remainder);
+    }
+
+    bool quotientNegative = negative != divisor.negative;
+    bool remainderNegative = negative;
+
+    if (divisor.limbs.size() == 1) {
+        uint32_t rest = divmodWord(divisor.limbs[0]);
+        remainder.limbs.assign(1, rest);
+    } else if (absLess(divisor)) {
+        remainder.limbs.swap(limbs);
+        limbs.assign(1, 0);
+    } else {
+        // Knuth's algorithm D in base 10^9. Scaling both operands so the
+        // divisor's top limb is at least BASE / 2 makes each two-limb
+        // quotient estimate at most two too large.
+        size_t n = divisor.limbs.size();
+        uint32_t factor = limb::BASE / (divisor.limbs.back() + 1);
+        LimbVector v = divisor.limbs;
+        multiplyByWord(v, factor);
+        LimbVector& u = remainder.limbs;
+        u = limbs;
+        u.push_back(0);
+        multiplyByWord(u, factor);
+
+        size_t m = u.size() - n - 1;
+        limbs.assign(m + 1, 0);
+        for (size_t j = m + 1; j-- > 0;) {
+            uint64_t numerator = (uint64_t)u[j + n] * limb::BASE + u[j + n - 1];
+            uint64_t qhat = numerator / v[n - 1];
+            uint64_t rhat = numerator % v[n - 1];
+            while (qhat >= limb::BASE || qhat * v[n - 2] > rhat * limb::BASE + u[j + n - 2]) {
+                qhat--;
+                rhat += v[n - 1];
+                if (rhat >= limb::BASE) break;
+            }
+
+            // u[j..j+n] -= qhat * v
+            uint64_t carry = 0;
+            int64_t borrow = 0;
+            for (size_t i = 0; i < n; i++) {
+                uint64_t product = qhat * v[i] + carry;
+                carry = product / limb::BASE;
+                int64_t diff = (int64_t)u[i + j] - (int64_t)(product % limb::BASE) - borrow;
+                borrow = diff < 0;
+                u[i + j] = (uint32_t)(borrow ? diff + limb::BASE : diff);
+            }
+            int64_t top = (int64_t)u[j + n] - (int64_t)carry - borrow;
+
+            if (top < 0) {
+                // The estimate was one too large: add the divisor back
+                qhat--;
+                uint32_t addCarry = limb::add(&u[j], &u[j], v.data(), n);
+                top += addCarry;
+            }
+            u[j + n] = (uint32_t)top;
+            limbs[j] = (uint32_t)qhat;
+        }
+
+        u.resize(n);
+        remainder.removeLeadingZeros();
+        remainder.divmodWord(factor);
+    }
+
+    negative = quotientNegative;
+    removeLeadingZeros();
+    remainder.negative = remainderNegative;
+    remainder.removeLeadingZeros();
+    return *this;
+}
+
+// Correctly rounded conversion that looks at the top 19 digits only: the
+// value lies in [m, m + 1) * 10^e, so when both bounds round to the same
+// double it is the answer. Near a rounding tie fall back to the full string.
+double BigInteger::toDouble() const {
+    size_t i = limbs.size() - 1;
+    unsigned long long mantissa = limbs[i];
+    int taken = decimalDigits(limbs[i]);
+    size_t exponent = 9 * i;
+
+    while (i > 0 && taken + 9 <= 19) {
+        mantissa = mantissa * limb::BASE + limbs[--i];
+        taken += 9;
+        exponent -= 9;
+    }
+    if (i > 0 && taken < 19) {
+        // Take the leading digits of the next limb
+        int partial = 19 - taken;
+        uint32_t scale = 1;
+        for (int k = 0; k < 9 - partial; k++) scale *= 10;
+        uint32_t power = limb::BASE / scale;
+        mantissa = mantissa * power + limbs[i - 1] / scale;
+        exponent -= partial;
+    }
+
+    double result;
+    if (exponent == 0) {
+        result = (double)mantissa;
+    } else {
+        char buffer[48];
+        std::snprintf(buffer, sizeof(buffer), "%llue%zu", mantissa, exponent);
+        double lower = std::strtod(buffer, nullptr);
+        std::snprintf(buffer, sizeof(buffer), "%llue%zu", mantissa + 1, exponent);
+        double upper = std::strtod(buffer, nullptr);
+        result = lower == upper ? lower : std::strtod(abs().toString().c_str(), nullptr);
+    }
+    return negative ? -result : result;
+}
+
+BigInteger BigInteger::fromDouble(double value) {
+    if (!isFinite(value)) {
+        return BigInteger(0);
+    }
+    if (std::fabs(value) < 9.2e18) {
+        return BigInteger((long long)value);
+    }
+    int exponent;
+    double mantissa = std::frexp(std::fabs(value), &exponent);
+    BigInteger result((long long)std::ldexp(mantissa, 53));
+    for (exponent -= 53; exponent > 0; exponent -= 30) {
+        result *= BigInteger(1LL << std::min(exponent, 30));
+    }
+    result.negative = value < 0;
+    return result;
+}
+
+bool BigInteger::isFinite(double value) {
+    unsigned long long bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return ((bits >> 52) & 0x7ff) != 0x7ff;
+}
+
+int BigInteger::compare(double value) const {
+    if (!isFinite(value)) {
+        unsigned long long bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        if (bits & ((1ULL << 52) - 1)) return 2;
+        return (bits >> 63) ? 1 : -1;
+    }
+    // Every finite double is below 10^309; 36 limbs hold at least 316 digits
+    if (limbs.size() >= 36) {
+        return negative ? -1 : 1;
+    }
+    double whole = std::trunc(value);
+    BigInteger wholeInt = fromDouble(whole);
+    if (*this < wholeInt) return -1;
+    if (wholeInt < *this) return 1;
+    double fraction = value - whole;
+    return fraction > 0 ? -1 : (fraction < 0 ? 1 : 0);
+}
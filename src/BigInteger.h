@@ -0,0 +1,257 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_BIGINTEGER_H
+#define PYTHON_INTERPRETER_BIGINTEGER_H
+
+#include "LimbKernels.h"
+#include "PoolAllocator.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Limb storage, recycled through SizeClassPool and accounted under
+// RuntimeStats::LIMBS
+using LimbVector = std::vector<uint32_t, PoolAllocator<uint32_t, RuntimeStats::LIMBS>>;
+
+// BigInteger class for arbitrary precision arithmetic
+class BigInteger {
+private:
+    // Base 10^9 limbs, least significant first; never empty and without
+    // leading zero limbs, so zero is the single limb 0
+    LimbVector limbs;
+    bool negative;
+
+    void removeLeadingZeros() {
+        while (limbs.size() > 1 && limbs.back() == 0) {
+            limbs.pop_back();
+        }
+        if (limbs.size() == 1 && limbs[0] == 0) {
+            negative = false;
+        }
+    }
+
+    // |this| += |other|
+    void addMagnitude(const BigInteger& other);
+    // |this| -= |other|, requires |this| >= |other|
+    void subMagnitude(const BigInteger& other);
+    // |this| = |other| - |this|, requires |other| > |this|
+    void reverseSubMagnitude(const BigInteger& other);
+    // this += (otherNegative ? -|other| : |other|)
+    BigInteger& addSigned(const BigInteger& other, bool otherNegative);
+
+public:
+    BigInteger() : limbs(1, 0), negative(false) {}
+    BigInteger(long long num);
+    BigInteger(const std::string& str);
+
+    std::string toString() const;
+
+    // Sets the value to num, reusing the limb buffer
+    BigInteger& assign(long long num);
+
+    // The value as a machine integer, when it has at most two limbs
+    // (magnitude below 10^18)
+    bool toInt64(int64_t& value) const {
+        if (limbs.size() > 2) {
+            return false;
+        }
+        uint64_t magnitude = limbs[0];
+        if (limbs.size() == 2) {
+            magnitude += (uint64_t)limbs[1] * limb::BASE;
+        }
+        value = negative ? -(int64_t)magnitude : (int64_t)magnitude;
+        return true;
+    }
+
+    size_t hash() const {
+        size_t seed = negative;
+        for (uint32_t limb : limbs) {
+            seed = seed * 1000000007 + limb;
+        }
+        return seed;
+    }
+
+    bool isZero() const {
+        return limbs.size() == 1 && limbs[0] == 0;
+    }
+
+    bool isNegative() const {
+        return negative && !isZero();
+    }
+
+    BigInteger abs() const {
+        BigInteger result = *this;
+        result.negative = false;
+        return result;
+    }
+
+    BigInteger operator-() const {
+        BigInteger result = *this;
+        return result.negate();
+    }
+
+    BigInteger& negate() {
+        if (!isZero()) {
+            negative = !negative;
+        }
+        return *this;
+    }
+
+    bool absLess(const BigInteger& other) const {
+        if (limbs.size() != other.limbs.size()) {
+            return limbs.size() < other.limbs.size();
+        }
+        return limb::compare(limbs.data(), other.limbs.data(), limbs.size()) < 0;
+    }
+
+    bool operator<(const BigInteger& other) const {
+        if (negative != other.negative) {
+            return negative;
+        }
+        if (negative) {
+            return other.absLess(*this);
+        }
+        return absLess(other);
+    }
+
+    bool operator>(const BigInteger& other) const {
+        return other < *this;
+    }
+
+    bool operator<=(const BigInteger& other) const {
+        return !(other < *this);
+    }
+
+    bool operator>=(const BigInteger& other) const {
+        return !(*this < other);
+    }
+
+    bool operator==(const BigInteger& other) const {
+        return negative == other.negative && limbs == other.limbs;
+    }
+
+    bool operator!=(const BigInteger& other) const {
+        return !(*this == other);
+    }
+
+    // In-place arithmetic: the left operand's limb storage is reused, so
+    // `x += y` in a loop does not allocate once x has grown to size.
+    BigInteger& operator+=(const BigInteger& other) {
+        return addSigned(other, other.negative);
+    }
+
+    BigInteger& operator-=(const BigInteger& other) {
+        return addSigned(other, !other.negative);
+    }
+
+    // Schoolbook in place for short operands, Karatsuba beyond
+    // KARATSUBA_THRESHOLD limbs
+    BigInteger& operator*=(const BigInteger& other);
+
+    static constexpr size_t KARATSUBA_THRESHOLD = 40;
+    // Karatsuba levels whose operands reach this many limbs hand their three
+    // sub-products to the thread pool; results do not depend on the count
+    static constexpr size_t PARALLEL_THRESHOLD = 2000;
+
+    // Threads used by large multiplications, including the calling thread
+    static void setThreadCount(size_t threads);
+
+    // Truncating division: this becomes the quotient and remainder receives
+    // the remainder, which takes the dividend's sign (C++ semantics).
+    BigInteger& divmod_inplace(const BigInteger& divisor, BigInteger& remainder);
+
+    // Magnitude as a single 32-bit word, if it fits
+    bool toWord(unsigned int& word) const {
+        if (limbs.size() > 2) {
+            return false;
+        }
+        uint64_t value = limbs[0];
+        if (limbs.size() == 2) {
+            value += (uint64_t)limbs[1] * limb::BASE;
+        }
+        if (value > 0xffffffffULL) {
+            return false;
+        }
+        word = (unsigned int)value;
+        return true;
+    }
+
+    // Divide the magnitude in place by a nonzero single-word divisor in one
+    // pass and return the remainder's magnitude. The sign is left alone, which
+    // makes the quotient truncate toward zero.
+    unsigned int divmodWord(unsigned int divisor);
+
+    BigInteger& operator/=(const BigInteger& other) {
+        BigInteger remainder;
+        return divmod_inplace(other, remainder);
+    }
+
+    BigInteger& operator%=(const BigInteger& other) {
+        BigInteger remainder;
+        divmod_inplace(other, remainder);
+        return *this = std::move(remainder);
+    }
+
+    // Value-returning operators; the rvalue overloads reuse the temporary
+    BigInteger operator+(const BigInteger& other) const & {
+        BigInteger result(*this);
+        return result += other;
+    }
+
+    BigInteger operator+(const BigInteger& other) && {
+        return std::move(*this += other);
+    }
+
+    BigInteger operator-(const BigInteger& other) const & {
+        BigInteger result(*this);
+        return result -= other;
+    }
+
+    BigInteger operator-(const BigInteger& other) && {
+        return std::move(*this -= other);
+    }
+
+    BigInteger operator*(const BigInteger& other) const & {
+        BigInteger result(*this);
+        return result *= other;
+    }
+
+    BigInteger operator*(const BigInteger& other) && {
+        return std::move(*this *= other);
+    }
+
+    BigInteger operator/(const BigInteger& other) const & {
+        BigInteger result(*this);
+        return result /= other;
+    }
+
+    BigInteger operator/(const BigInteger& other) && {
+        return std::move(*this /= other);
+    }
+
+    BigInteger operator%(const BigInteger& other) const & {
+        BigInteger result(*this);
+        return result %= other;
+    }
+
+    BigInteger operator%(const BigInteger& other) && {
+        return std::move(*this %= other);
+    }
+
+    // Correctly rounded conversion to the nearest double
+    double toDouble() const;
+
+    // Exact conversion of an integral double, including values beyond 2^63.
+    // Infinities and NaN have no integer counterpart and map to zero.
+    static BigInteger fromDouble(double value);
+
+    // -Ofast assumes finite math, so classify doubles by their bit pattern.
+    static bool isFinite(double value);
+
+    // Exact three-way comparison with a double: -1, 0 or 1 as this number is
+    // less than, equal to or greater than value, and 2 when value is NaN.
+    int compare(double value) const;
+};
+
+#endif//PYTHON_INTERPRETER_BIGINTEGER_H
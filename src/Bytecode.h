@@ -0,0 +1,164 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_BYTECODE_H
+#define PYTHON_INTERPRETER_BYTECODE_H
+
+#include "Value.h"
+#include "antlr4-runtime.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Instruction set of the virtual machine. Instructions name their operands
+// directly: a, b and c are operands (see below), or index the code object's
+// tables (call sites, assignments), or hold jump targets and counts, and sub
+// carries the BinaryOp or CompareOp of operator instructions. Kept as a list
+// so the enum and the VM's dispatch table are generated in the same order.
+#define PYTHON_INTERPRETER_OPCODES(X) \
+    X(MOVE)                 /* a = b */ \
+    X(LOAD_DYNAMIC)         /* a = variable globalNames[b] as seen from here: an outer call's parameter, else the global */ \
+    X(LOAD_CALLABLE)        /* a = globalNames[b] as a string if a function has that name, else its variable */ \
+    X(ASSIGN)               /* bind the c registers from b to the target lists of assignments[a] */ \
+    X(BUILD_TUPLE)          /* a = tuple of the c registers from b */ \
+    X(FORMAT)               /* a = f-string text of the c registers from b, joined by ", " */ \
+    X(BUILD_STRING)         /* a = concatenation of the c string registers from b */ \
+    X(NOT)                  /* a = not b */ \
+    X(NEGATE)               /* a = -b */ \
+    X(JUMP)                 /* continue at a */ \
+    X(JUMP_IF_FALSE)        /* continue at a when b is false */ \
+    X(JUMP_IF_TRUE)         /* continue at a when b is true */ \
+    X(LOOP)                 /* a while loop's back-edge to a; b counts passes until the loop is hot */ \
+    X(LOOP_NATIVE)          /* a LOOP the Jit compiled as its loop c: run it natively when its operands allow */ \
+    /* Binary operators a = b sub c; the plain forms quicken on first execution */ \
+    X(ADD) X(ADD_INT) X(ADD_FLOAT) X(ADD_STRING) \
+    X(SUB) X(SUB_INT) X(SUB_FLOAT) \
+    X(MUL) X(MUL_INT) X(MUL_FLOAT) \
+    X(DIV) X(DIV_FLOAT) \
+    X(FLOORDIV) X(FLOORDIV_INT) \
+    X(MOD) X(MOD_INT) \
+    X(BINARY_GENERIC) \
+    /* The same over operands the compiler proved are ints: no type guard, and int64 arithmetic until it would overflow */ \
+    X(ADD_I64) X(SUB_I64) X(MUL_I64) X(FLOORDIV_I64) X(MOD_I64) \
+    /* Comparisons of b and c: a = the result, or with BRANCH_IF_FALSE in sub continue at a when false */ \
+    X(LT) X(LT_INT) X(LT_FLOAT) X(LT_STRING) \
+    X(GT) X(GT_INT) X(GT_FLOAT) X(GT_STRING) \
+    X(LE) X(LE_INT) X(LE_FLOAT) X(LE_STRING) \
+    X(GE) X(GE_INT) X(GE_FLOAT) X(GE_STRING) \
+    X(EQ) X(EQ_INT) X(EQ_FLOAT) X(EQ_STRING) \
+    X(NE) X(NE_INT) X(NE_FLOAT) X(NE_STRING) \
+    X(COMPARE_GENERIC) \
+    X(LT_I64) X(GT_I64) X(LE_I64) X(GE_I64) X(EQ_I64) X(NE_I64) \
+    X(CALL)                 /* a = call globalNames[calls[b].name] with the arguments in the registers from c */ \
+    X(CALL_BUILTIN)         /* a CALL whose name the builtin builtinNamed(name) answers to */ \
+    X(CALL_FUNCTION)        /* a CALL whose name a def has bound */ \
+    X(CALL_VALUE)           /* the same, calling the function named by register c - 1 */ \
+    X(TAIL_CALL)            /* a CALL the running def makes of its own name just before returning a */ \
+    X(MAKE_FUNCTION)        /* bind functions[a], its default values in the registers from b */ \
+    X(RETURN)               /* return a */ \
+    X(LINE_ENTER)           /* line profiler: statement lines[a] starts */ \
+    X(LINE_EXIT)            \
+    X(LINE_ITERATION)       /* line profiler: one pass through the loop at lines[a] */ \
+    X(HALT)
+
+// Operands: below GLOBAL_OPERAND a register, relative to the running call's
+// window; then the program's global variables by name index; then the
+// running code object's constants
+constexpr uint32_t GLOBAL_OPERAND = 1u << 30;
+constexpr uint32_t CONSTANT_OPERAND = 2u << 30;
+
+inline bool isRegister(uint32_t operand) {
+    return operand < GLOBAL_OPERAND;
+}
+
+// Set in a comparison's sub when it branches instead of storing a bool
+constexpr uint8_t BRANCH_IF_FALSE = 0x80;
+
+constexpr uint32_t NO_PLAN = UINT32_MAX;
+
+enum class Opcode : uint8_t {
+#define PYTHON_INTERPRETER_OPCODE_ENUM(name) name,
+    PYTHON_INTERPRETER_OPCODES(PYTHON_INTERPRETER_OPCODE_ENUM)
+#undef PYTHON_INTERPRETER_OPCODE_ENUM
+    OPCODE_COUNT
+};
+
+struct Instruction {
+    // Address of the handler when the VM dispatches by threaded code; kept
+    // in step with op whenever an instruction is quickened
+    const void* handler = nullptr;
+    Opcode op;
+    uint8_t sub = 0;
+    uint32_t a = 0;
+    uint32_t b = 0;
+    uint32_t c = 0;
+};
+
+struct CallSite {
+    // Index into globalNames
+    uint32_t name;
+    uint32_t positional;
+    // Names of the keyword arguments, which follow the positional ones
+    std::vector<std::string> keywords;
+    // The VM's plan for binding the keyword arguments to the def the site
+    // last called; NO_PLAN until it calls one
+    uint32_t plan = NO_PLAN;
+};
+
+struct CodeObject {
+    std::string name;
+    std::vector<Instruction> instructions;
+    std::vector<Value> constants;
+    std::vector<CallSite> calls;
+    // Per assignment statement, the operands each target list stores to
+    std::vector<std::vector<std::vector<uint32_t>>> assignments;
+    // Statement starts, for the line profiler
+    std::vector<antlr4::Token*> lines;
+    // Size of a call's window: the parameters, then temporaries
+    size_t registerCount = 0;
+    size_t parameterCount = 0;
+};
+
+struct FunctionCode {
+    std::string name;
+    // globalNames index of name
+    uint32_t global;
+    std::vector<std::string> params;
+    // globalNames indices of params, which LOAD_DYNAMIC matches against
+    std::vector<uint32_t> paramNames;
+    size_t defaultCount;
+    CodeObject* code;
+    // The body compiled again for calls whose intParams registers hold
+    // ints, with operators over them statically typed; null when that
+    // would type nothing
+    CodeObject* intCode = nullptr;
+    std::vector<uint32_t> intParams;
+    // Reads nothing but its parameters, assigns nothing else and calls only
+    // conversions and other pure defs, so --memoize may cache its results
+    bool pure = false;
+};
+
+enum class Builtin : uint8_t { NONE, PRINT, INT, FLOAT, STR, BOOL };
+
+inline Builtin builtinNamed(const std::string& name) {
+    if (name == "print") return Builtin::PRINT;
+    if (name == "int") return Builtin::INT;
+    if (name == "float") return Builtin::FLOAT;
+    if (name == "str") return Builtin::STR;
+    if (name == "bool") return Builtin::BOOL;
+    return Builtin::NONE;
+}
+
+inline bool isBuiltinFunction(const std::string& name) {
+    return builtinNamed(name) != Builtin::NONE;
+}
+
+// Everything the compiler produced for one source file
+struct Program {
+    std::vector<std::unique_ptr<CodeObject>> codeObjects;
+    std::vector<FunctionCode> functions;
+    CodeObject* module = nullptr;
+    // Every name the program mentions; global variable i is globalNames[i]
+    std::vector<std::string> globalNames;
+};
+
+#endif//PYTHON_INTERPRETER_BYTECODE_H
@@ -0,0 +1,1471 @@
+#include "Compiler.h"
+#include "LineProfiler.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// ints: both operands are statically ints
+Opcode binaryOpcode(BinaryOp op, bool ints) {
+    switch (op) {
+        case BinaryOp::ADD:
+            return ints ? Opcode::ADD_I64 : Opcode::ADD;
+        case BinaryOp::SUB:
+            return ints ? Opcode::SUB_I64 : Opcode::SUB;
+        case BinaryOp::MUL:
+            return ints ? Opcode::MUL_I64 : Opcode::MUL;
+        case BinaryOp::DIV:
+            return Opcode::DIV;
+        case BinaryOp::FLOORDIV:
+            return ints ? Opcode::FLOORDIV_I64 : Opcode::FLOORDIV;
+        case BinaryOp::MOD:
+            return ints ? Opcode::MOD_I64 : Opcode::MOD;
+    }
+    return Opcode::BINARY_GENERIC;
+}
+
+Opcode compareOpcode(CompareOp op, bool ints) {
+    switch (op) {
+        case CompareOp::LT:
+            return ints ? Opcode::LT_I64 : Opcode::LT;
+        case CompareOp::GT:
+            return ints ? Opcode::GT_I64 : Opcode::GT;
+        case CompareOp::LE:
+            return ints ? Opcode::LE_I64 : Opcode::LE;
+        case CompareOp::GE:
+            return ints ? Opcode::GE_I64 : Opcode::GE;
+        case CompareOp::EQ:
+            return ints ? Opcode::EQ_I64 : Opcode::EQ;
+        case CompareOp::NE:
+            return ints ? Opcode::NE_I64 : Opcode::NE;
+    }
+    return Opcode::COMPARE_GENERIC;
+}
+
+// Like CPython, repetitions that would build a longer string are left to
+// run time rather than folded
+constexpr size_t MAX_FOLDED_STRING = 4096;
+
+// Whether a * b folds to a string of at most MAX_FOLDED_STRING characters,
+// or is no string repetition at all
+bool repetitionFits(const Value& a, const Value& b) {
+    const Value* text = a.type == ValueType::STRING ? &a : b.type == ValueType::STRING ? &b : nullptr;
+    const Value* count = text == &a ? &b : &a;
+    if (!text || count->type != ValueType::INT || count->intVal.isNegative()) {
+        return true;
+    }
+    unsigned int times;
+    return count->intVal.toWord(times) && text->strVal.size() * (uint64_t)times <= MAX_FOLDED_STRING;
+}
+
+bool isIntTyped(Opcode op) {
+    switch (op) {
+        case Opcode::ADD_I64:
+        case Opcode::SUB_I64:
+        case Opcode::MUL_I64:
+        case Opcode::FLOORDIV_I64:
+        case Opcode::MOD_I64:
+        case Opcode::LT_I64:
+        case Opcode::GT_I64:
+        case Opcode::LE_I64:
+        case Opcode::GE_I64:
+        case Opcode::EQ_I64:
+        case Opcode::NE_I64:
+            return true;
+        default:
+            return false;
+    }
+}
+
+}
+
+std::any Compiler::visitFile_input(Python3Parser::File_inputContext *ctx) {
+    collectNames(ctx);
+    profileLines = LineProfiler::enabled();
+
+    program.codeObjects.push_back(std::make_unique<CodeObject>());
+    program.module = program.codeObjects.back().get();
+    program.module->name = "<module>";
+    unit.code = program.module;
+
+    for (auto stmt : ctx->stmt()) {
+        visit(stmt);
+    }
+    emit(Opcode::HALT);
+    markPureFunctions(ctx);
+    return nullptr;
+}
+
+std::any Compiler::visitFuncdef(Python3Parser::FuncdefContext *ctx) {
+    FunctionCode function;
+    function.name = ctx->NAME()->getText();
+    function.global = globalIndex(function.name);
+
+    // Defaults are evaluated each time the def runs, in the enclosing code
+    std::vector<antlr4::tree::ParseTree*> defaults;
+    if (auto args = ctx->parameters()->typedargslist()) {
+        for (auto tfpdef : args->tfpdef()) {
+            function.params.push_back(tfpdef->NAME()->getText());
+            function.paramNames.push_back(globalIndex(function.params.back()));
+        }
+        auto tests = args->test();
+        defaults.assign(tests.begin(), tests.end());
+    }
+    function.defaultCount = defaults.size();
+    uint32_t firstDefault = evaluateConsecutive(defaults);
+
+    function.code = compileBody(ctx, function, {});
+
+    // The int-specialized version is only worth a check on each call when
+    // it types some operator the generic one leaves to quickening. A nested
+    // def would be compiled once per version, so such bodies are left alone.
+    std::unordered_set<std::string> intParams = intParameters(ctx, function);
+    if (!intParams.empty() && !containsFuncdef(ctx->suite())) {
+        CodeObject* intCode = compileBody(ctx, function, intParams);
+        auto typed = [](const CodeObject* code) {
+            return std::count_if(code->instructions.begin(), code->instructions.end(),
+                                 [](const Instruction& instruction) { return isIntTyped(instruction.op); });
+        };
+        if (typed(intCode) > typed(function.code)) {
+            function.intCode = intCode;
+            for (size_t i = 0; i < function.params.size(); i++) {
+                if (intParams.count(function.params[i])) {
+                    function.intParams.push_back(i);
+                }
+            }
+            // Calls size the window before choosing a version
+            size_t registers = std::max(function.code->registerCount, intCode->registerCount);
+            function.code->registerCount = intCode->registerCount = registers;
+        } else {
+            program.codeObjects.pop_back();
+        }
+    }
+
+    program.functions.push_back(std::move(function));
+    funcdefs.push_back(ctx);
+    emit(Opcode::MAKE_FUNCTION, program.functions.size() - 1, firstDefault);
+    return nullptr;
+}
+
+CodeObject* Compiler::compileBody(Python3Parser::FuncdefContext* ctx, const FunctionCode& function,
+                                  std::unordered_set<std::string> intParams) {
+    program.codeObjects.push_back(std::make_unique<CodeObject>());
+    CodeObject* code = program.codeObjects.back().get();
+    code->name = function.name;
+
+    // Parameters take the first registers of the window, in order
+    Unit enclosing = std::move(unit);
+    unit = Unit();
+    unit.code = code;
+    unit.isFunction = true;
+    for (size_t i = 0; i < function.params.size(); i++) {
+        unit.params.emplace(function.params[i], i);
+    }
+    unit.intParams = std::move(intParams);
+    unit.freeRegister = function.params.size();
+    unit.firstTemporary = unit.freeRegister;
+    unit.code->parameterCount = unit.freeRegister;
+    unit.code->registerCount = unit.freeRegister;
+    visit(ctx->suite());
+    emit(Opcode::RETURN, constantOperand(Value::None()));
+    unit = std::move(enclosing);
+    return code;
+}
+
+std::any Compiler::visitStmt(Python3Parser::StmtContext *ctx) {
+    // A statement's temporaries are free again once it has run
+    uint32_t registers = unit.freeRegister;
+    if (!profileLines) {
+        visitChildren(ctx);
+        unit.freeRegister = registers;
+        return nullptr;
+    }
+    unit.code->lines.push_back(ctx->getStart());
+    emit(Opcode::LINE_ENTER, unit.code->lines.size() - 1);
+    unit.openLines++;
+    visitChildren(ctx);
+    unit.openLines--;
+    emit(Opcode::LINE_EXIT);
+    unit.freeRegister = registers;
+    return nullptr;
+}
+
+std::any Compiler::visitExpr_stmt(Python3Parser::Expr_stmtContext *ctx) {
+    auto testlists = ctx->testlist();
+
+    if (testlists.size() == 1) {
+        // Just an expression
+        for (auto test : testlists[0]->test()) {
+            evaluate(test);
+        }
+        return nullptr;
+    }
+
+    if (ctx->augassign()) {
+        // Only a single target is updated
+        auto targets = testlists[0]->test();
+        if (targets.size() != 1) {
+            return nullptr;
+        }
+        std::string name = targets[0]->getText();
+        std::string text = ctx->augassign()->getText();
+        text.pop_back();  // the binary operator: "+=" -> "+"
+        BinaryOp op = binaryOp(text);
+
+        // The operator stores straight into the target, in place for ints;
+        // a call on the right could rebind the target after Python would
+        // have read it, so then it is read into a temporary first
+        uint32_t left = snapshot(variable(name), testlists[1]);
+        auto rightTests = testlists[1]->test();
+        uint32_t right = evaluate(rightTests[0]);
+        for (size_t i = 1; i < rightTests.size(); i++) {
+            evaluate(rightTests[i]);
+        }
+        bool ints = isInt(staticType(targets[0]), staticType(rightTests[0]));
+        emit(binaryOpcode(op, ints), storeOperand(name), left, right, (uint8_t)op);
+        return nullptr;
+    }
+
+    // A single value for a single target is computed into the variable
+    auto values = testlists.back()->test();
+    if (testlists.size() == 2 && values.size() == 1 && testlists[0]->test().size() == 1) {
+        evaluate(values[0], storeOperand(testlists[0]->test()[0]->getText()));
+        return nullptr;
+    }
+
+    // Regular assignment or chained assignment; targets are bound left to
+    // right, as in Python
+    uint32_t first = evaluateConsecutive({values.begin(), values.end()});
+    std::vector<std::vector<uint32_t>> targets;
+    for (size_t i = 0; i + 1 < testlists.size(); i++) {
+        targets.emplace_back();
+        for (auto test : testlists[i]->test()) {
+            targets.back().push_back(storeOperand(test->getText()));
+        }
+    }
+    unit.code->assignments.push_back(std::move(targets));
+    emit(Opcode::ASSIGN, unit.code->assignments.size() - 1, first, values.size());
+    return nullptr;
+}
+
+std::any Compiler::visitBreak_stmt(Python3Parser::Break_stmtContext *) {
+    if (unit.loops.empty()) {
+        return nullptr;
+    }
+    emitLineExits(unit.loops.back().openLines);
+    unit.loops.back().breaks.push_back(emit(Opcode::JUMP));
+    return nullptr;
+}
+
+std::any Compiler::visitContinue_stmt(Python3Parser::Continue_stmtContext *) {
+    if (unit.loops.empty()) {
+        return nullptr;
+    }
+    emitLineExits(unit.loops.back().openLines);
+    emit(Opcode::JUMP, unit.loops.back().start);
+    return nullptr;
+}
+
+std::any Compiler::visitReturn_stmt(Python3Parser::Return_stmtContext *ctx) {
+    uint32_t value;
+    if (!ctx->testlist()) {
+        value = constantOperand(Value::None());
+    } else if (ctx->testlist()->test().size() == 1) {
+        value = evaluate(ctx->testlist()->test(0));
+        // A def returning what a call of its own name returns may reuse its
+        // window for that call, so tail recursion runs in constant space.
+        // The line profiler's statement exits would be skipped, so it keeps
+        // the plain call.
+        if (unit.isFunction && !profileLines && !isBuiltinFunction(unit.code->name) &&
+            isCall(ctx->testlist()->test(0))) {
+            Instruction& last = unit.code->instructions.back();
+            if (last.op == Opcode::CALL && last.a == value &&
+                program.globalNames[unit.code->calls[last.b].name] == unit.code->name) {
+                last.op = Opcode::TAIL_CALL;
+            }
+        }
+    } else {
+        auto tests = ctx->testlist()->test();
+        value = evaluateConsecutive({tests.begin(), tests.end()});
+        emit(Opcode::BUILD_TUPLE, value, value, tests.size());
+    }
+    emitLineExits(0);
+    emit(Opcode::RETURN, value);
+    return nullptr;
+}
+
+std::any Compiler::visitIf_stmt(Python3Parser::If_stmtContext *ctx) {
+    auto tests = ctx->test();
+    auto suites = ctx->suite();
+    bool hasElse = suites.size() > tests.size();
+
+    std::vector<size_t> ends;
+    for (size_t i = 0; i < tests.size(); i++) {
+        std::vector<size_t> next;
+        uint32_t registers = unit.freeRegister;
+        branchIfFalse(tests[i], next);
+        unit.freeRegister = registers;
+        visit(suites[i]);
+        if (i + 1 < tests.size() || hasElse) {
+            ends.push_back(emit(Opcode::JUMP));
+        }
+        bindLabels(next);
+    }
+
+    // else clause
+    if (hasElse) {
+        visit(suites.back());
+    }
+    bindLabels(ends);
+    return nullptr;
+}
+
+std::any Compiler::visitWhile_stmt(Python3Parser::While_stmtContext *ctx) {
+    // The condition's invariants are computed before its first test, which
+    // always runs; the body's only once that test passes, so a loop that
+    // never runs computes nothing it would not have
+    uint32_t enclosingTemporaries = unit.firstTemporary;
+    std::vector<antlr4::tree::ParseTree*> conditionInvariants;
+    std::vector<antlr4::tree::ParseTree*> bodyInvariants;
+    collectInvariants(ctx, conditionInvariants, bodyInvariants);
+    hoist(conditionInvariants);
+    std::vector<size_t> exits;
+    std::vector<size_t> entry;
+    if (!bodyInvariants.empty()) {
+        uint32_t registers = unit.freeRegister;
+        branchIfFalse(ctx->test(), exits);
+        unit.freeRegister = registers;
+        hoist(bodyInvariants);
+        entry.push_back(emit(Opcode::JUMP));
+    }
+    unit.firstTemporary = unit.freeRegister;
+
+    Loop loop;
+    loop.start = here();
+    loop.openLines = unit.openLines;
+
+    uint32_t registers = unit.freeRegister;
+    branchIfFalse(ctx->test(), exits);
+    unit.freeRegister = registers;
+    bindLabels(entry);
+    if (profileLines) {
+        unit.code->lines.push_back(ctx->getStart());
+        emit(Opcode::LINE_ITERATION, unit.code->lines.size() - 1);
+    }
+
+    unit.loops.push_back(std::move(loop));
+    visit(ctx->suite());
+    emit(Opcode::LOOP, unit.loops.back().start);
+    Loop finished = std::move(unit.loops.back());
+    unit.loops.pop_back();
+
+    bindLabels(exits);
+    bindLabels(finished.breaks);
+    // The hoisted values' registers are the statement's, freed after it
+    for (auto hoisted = unit.hoisted.begin(); hoisted != unit.hoisted.end();) {
+        if (hoisted->second >= enclosingTemporaries) {
+            hoisted = unit.hoisted.erase(hoisted);
+        } else {
+            ++hoisted;
+        }
+    }
+    unit.firstTemporary = enclosingTemporaries;
+    return nullptr;
+}
+
+std::any Compiler::visitSuite(Python3Parser::SuiteContext *ctx) {
+    if (ctx->simple_stmt()) {
+        return visit(ctx->simple_stmt());
+    }
+    for (auto stmt : ctx->stmt()) {
+        visit(stmt);
+    }
+    return nullptr;
+}
+
+std::any Compiler::visitOr_test(Python3Parser::Or_testContext *ctx) {
+    auto andTests = ctx->and_test();
+    if (andTests.size() == 1) {
+        return visit(andTests[0]);
+    }
+    uint32_t dst = target;
+    if (const Value* value = constant(ctx)) {
+        return moveTo(constantOperand(*value), dst);
+    }
+
+    // Each operand lands in one temporary, which keeps the first true one
+    uint32_t result = allocateRegister();
+    std::vector<size_t> ends;
+    for (size_t i = 0; i < andTests.size(); i++) {
+        evaluate(andTests[i], result);
+        if (i + 1 < andTests.size()) {
+            ends.push_back(emit(Opcode::JUMP_IF_TRUE, 0, result));  // Short-circuit
+        }
+    }
+    bindLabels(ends);
+    return moveTo(result, dst);
+}
+
+std::any Compiler::visitAnd_test(Python3Parser::And_testContext *ctx) {
+    auto notTests = ctx->not_test();
+    if (notTests.size() == 1) {
+        return visit(notTests[0]);
+    }
+    uint32_t dst = target;
+    if (const Value* value = constant(ctx)) {
+        return moveTo(constantOperand(*value), dst);
+    }
+
+    uint32_t result = allocateRegister();
+    std::vector<size_t> ends;
+    for (size_t i = 0; i < notTests.size(); i++) {
+        evaluate(notTests[i], result);
+        if (i + 1 < notTests.size()) {
+            ends.push_back(emit(Opcode::JUMP_IF_FALSE, 0, result));  // Short-circuit
+        }
+    }
+    bindLabels(ends);
+    return moveTo(result, dst);
+}
+
+std::any Compiler::visitNot_test(Python3Parser::Not_testContext *ctx) {
+    if (!ctx->NOT()) {
+        return visit(ctx->comparison());
+    }
+    uint32_t dst = target;
+    if (const Value* value = constant(ctx)) {
+        return moveTo(constantOperand(*value), dst);
+    }
+    uint32_t operand = evaluate(ctx->not_test());
+    uint32_t result = dst == ANY ? allocateRegister() : dst;
+    emit(Opcode::NOT, result, operand);
+    return result;
+}
+
+std::any Compiler::visitComparison(Python3Parser::ComparisonContext *ctx) {
+    // children alternate operand, operator, operand, ...
+    const auto& children = ctx->children;
+    if (children.size() == 1) {
+        return visit(children[0]);
+    }
+    uint32_t dst = target;
+    if (const Value* value = constant(ctx)) {
+        return moveTo(constantOperand(*value), dst);
+    }
+
+    uint32_t left = snapshot(evaluate(children[0]), children[2]);
+    if (children.size() == 3) {
+        uint32_t right = evaluate(children[2]);
+        uint32_t result = dst == ANY ? allocateRegister() : dst;
+        CompareOp op = compareOp(children[1]->getText());
+        emit(compareOpcode(op, isInt(staticType(children[0]), staticType(children[2]))), result, left, right,
+             (uint8_t)op);
+        return result;
+    }
+
+    // Chained comparisons stop at the first false link, as in Python. The
+    // result goes to a temporary, since a target that is also an operand
+    // is still read after the first link.
+    uint32_t result = allocateRegister();
+    std::vector<size_t> ends;
+    for (size_t i = 1; i + 1 < children.size(); i += 2) {
+        left = snapshot(left, children[i + 1]);
+        uint32_t right = evaluate(children[i + 1]);
+        bool last = i + 2 >= children.size();
+        if (!last) {
+            right = snapshot(right, children[i + 3]);
+        }
+        CompareOp op = compareOp(children[i]->getText());
+        bool ints = isInt(staticType(children[i - 1]), staticType(children[i + 1]));
+        emit(compareOpcode(op, ints), result, left, right, (uint8_t)op);
+        if (!last) {
+            ends.push_back(emit(Opcode::JUMP_IF_FALSE, 0, result));
+        }
+        left = right;
+    }
+    bindLabels(ends);
+    return moveTo(result, dst);
+}
+
+std::any Compiler::visitArith_expr(Python3Parser::Arith_exprContext *ctx) {
+    return emitOperators(ctx);
+}
+
+std::any Compiler::visitTerm(Python3Parser::TermContext *ctx) {
+    return emitOperators(ctx);
+}
+
+std::any Compiler::visitFactor(Python3Parser::FactorContext *ctx) {
+    if (!ctx->ADD() && !ctx->MINUS()) {
+        return visit(ctx->atom_expr());
+    }
+    uint32_t dst = target;
+    if (const Value* value = constant(ctx)) {
+        return moveTo(constantOperand(*value), dst);
+    }
+    uint32_t operand = evaluate(ctx->factor());
+    if (!ctx->MINUS()) {
+        return moveTo(operand, dst);
+    }
+    uint32_t result = dst == ANY ? allocateRegister() : dst;
+    emit(Opcode::NEGATE, result, operand);
+    return result;
+}
+
+std::any Compiler::visitAtom_expr(Python3Parser::Atom_exprContext *ctx) {
+    auto atom = ctx->atom();
+    auto trailer = ctx->trailer();
+    if (!trailer) {
+        return visit(atom);
+    }
+
+    // A call. Named callees are resolved when the call runs; any other
+    // callee is evaluated first, into the register below the arguments, and
+    // called by the name it holds. The arguments are evaluated into
+    // consecutive registers, which become the start of the callee's window.
+    uint32_t dst = target;
+    uint32_t result = dst == ANY ? allocateRegister() : dst;
+    bool named = atom->NAME() != nullptr;
+    if (!named) {
+        uint32_t callee = allocateRegister();
+        evaluate(atom, callee);
+        unit.freeRegister = callee + 1;
+    }
+
+    CallSite site;
+    site.name = named ? globalIndex(atom->NAME()->getText()) : 0;
+    site.positional = 0;
+    std::vector<antlr4::tree::ParseTree*> arguments;
+    if (auto arglist = trailer->arglist()) {
+        for (auto argument : arglist->argument()) {
+            auto tests = argument->test();
+            if (tests.size() == 2) {
+                // Keyword argument: test '=' test
+                site.keywords.push_back(tests[0]->getText());
+                arguments.push_back(tests[1]);
+            } else {
+                if (!site.keywords.empty()) {
+                    throw std::runtime_error("positional argument follows keyword argument");
+                }
+                site.positional++;
+                arguments.push_back(tests[0]);
+            }
+        }
+    }
+    uint32_t first = evaluateConsecutive(arguments);
+
+    unit.code->calls.push_back(std::move(site));
+    emit(named ? Opcode::CALL : Opcode::CALL_VALUE, result, unit.code->calls.size() - 1, first);
+    unit.freeRegister = named ? first : first - 1;
+    return result;
+}
+
+std::any Compiler::visitAtom(Python3Parser::AtomContext *ctx) {
+    if (const Value* value = constant(ctx)) {
+        return moveTo(constantOperand(*value), target);
+    } else if (ctx->NAME()) {
+        return loadName(ctx->NAME()->getText(), target);
+    } else if (ctx->format_string()) {
+        return visit(ctx->format_string());
+    } else if (ctx->test()) {
+        return visit(ctx->test());
+    }
+    return moveTo(constantOperand(Value::None()), target);
+}
+
+std::any Compiler::visitFormat_string(Python3Parser::Format_stringContext *ctx) {
+    uint32_t dst = target;
+
+    // Literal text, or an expression inside {}
+    std::vector<antlr4::tree::ParseTree*> parts;
+    for (auto child : ctx->children) {
+        if (auto terminal = dynamic_cast<antlr4::tree::TerminalNode*>(child)) {
+            if (terminal->getSymbol()->getType() == Python3Parser::FORMAT_STRING_LITERAL) {
+                parts.push_back(child);
+            }
+        } else if (dynamic_cast<Python3Parser::TestlistContext*>(child)) {
+            parts.push_back(child);
+        }
+    }
+    if (parts.empty()) {
+        return moveTo(constantOperand(Value::String("")), dst);
+    }
+
+    // Each part becomes a string in consecutive registers, which
+    // BUILD_STRING joins; a single part is the result itself
+    uint32_t first = unit.freeRegister;
+    for (auto part : parts) {
+        uint32_t partRegister = parts.size() == 1 && dst != ANY ? dst : allocateRegister();
+        if (auto testlist = dynamic_cast<Python3Parser::TestlistContext*>(part)) {
+            auto tests = testlist->test();
+            uint32_t values = evaluateConsecutive({tests.begin(), tests.end()});
+            emit(Opcode::FORMAT, partRegister, values, tests.size());
+        } else {
+            std::string text = part->getText();
+            // Replace {{ with { and }} with }
+            std::string processed;
+            for (size_t j = 0; j < text.length(); j++) {
+                if (j + 1 < text.length() && text[j] == '{' && text[j+1] == '{') {
+                    processed += '{';
+                    j++;
+                } else if (j + 1 < text.length() && text[j] == '}' && text[j+1] == '}') {
+                    processed += '}';
+                    j++;
+                } else {
+                    processed += text[j];
+                }
+            }
+            if (parts.size() == 1) {
+                unit.freeRegister = first;
+                return moveTo(constantOperand(Value::String(processed)), dst);
+            }
+            emit(Opcode::MOVE, partRegister, constantOperand(Value::String(processed)));
+        }
+        if (parts.size() == 1) {
+            return partRegister;
+        }
+        unit.freeRegister = partRegister + 1;
+    }
+
+    uint32_t result = dst == ANY ? first : dst;
+    emit(Opcode::BUILD_STRING, result, first, parts.size());
+    unit.freeRegister = first + 1;
+    return result;
+}
+
+void Compiler::collectNames(antlr4::tree::ParseTree* tree) {
+    if (auto funcdef = dynamic_cast<Python3Parser::FuncdefContext*>(tree)) {
+        functionNames.insert(funcdef->NAME()->getText());
+        if (auto args = funcdef->parameters()->typedargslist()) {
+            for (auto tfpdef : args->tfpdef()) {
+                parameterNames.insert(tfpdef->NAME()->getText());
+            }
+        }
+    }
+    for (auto child : tree->children) {
+        collectNames(child);
+    }
+}
+
+size_t Compiler::emit(Opcode op, uint32_t a, uint32_t b, uint32_t c, uint8_t sub) {
+    Instruction instruction;
+    instruction.op = op;
+    instruction.sub = sub;
+    instruction.a = a;
+    instruction.b = b;
+    instruction.c = c;
+    unit.code->instructions.push_back(instruction);
+    return unit.code->instructions.size() - 1;
+}
+
+uint32_t Compiler::globalIndex(const std::string& name) {
+    auto found = globalIndices.find(name);
+    if (found != globalIndices.end()) {
+        return found->second;
+    }
+    program.globalNames.push_back(name);
+    return globalIndices[name] = program.globalNames.size() - 1;
+}
+
+uint32_t Compiler::constantOperand(const Value& value) {
+    unit.code->constants.push_back(value);
+    return CONSTANT_OPERAND + (unit.code->constants.size() - 1);
+}
+
+uint32_t Compiler::allocateRegister() {
+    uint32_t allocated = unit.freeRegister++;
+    unit.code->registerCount = std::max<size_t>(unit.code->registerCount, unit.freeRegister);
+    return allocated;
+}
+
+uint32_t Compiler::evaluate(antlr4::tree::ParseTree* tree, uint32_t dst) {
+    uint32_t enclosing = target;
+    target = dst;
+    uint32_t result = std::any_cast<uint32_t>(visit(tree));
+    target = enclosing;
+    return result;
+}
+
+uint32_t Compiler::evaluateConsecutive(const std::vector<antlr4::tree::ParseTree*>& trees) {
+    uint32_t first = unit.freeRegister;
+    for (auto tree : trees) {
+        uint32_t value = allocateRegister();
+        evaluate(tree, value);
+        unit.freeRegister = value + 1;
+    }
+    return first;
+}
+
+uint32_t Compiler::moveTo(uint32_t result, uint32_t dst) {
+    if (dst == ANY || dst == result) {
+        return result;
+    }
+    emit(Opcode::MOVE, dst, result);
+    return dst;
+}
+
+uint32_t Compiler::snapshot(uint32_t operand, antlr4::tree::ParseTree* later) {
+    // Registers are the running call's own, which no callee can rebind
+    if (isRegister(operand) || operand >= CONSTANT_OPERAND || !containsCall(later)) {
+        return operand;
+    }
+    uint32_t copy = allocateRegister();
+    emit(Opcode::MOVE, copy, operand);
+    return copy;
+}
+
+uint32_t Compiler::variable(const std::string& name, uint32_t dst) {
+    auto param = unit.params.find(name);
+    if (param != unit.params.end()) {
+        return param->second;
+    }
+    if (unit.isFunction && parameterNames.count(name)) {
+        uint32_t result = dst == ANY ? allocateRegister() : dst;
+        emit(Opcode::LOAD_DYNAMIC, result, globalIndex(name));
+        return result;
+    }
+    return GLOBAL_OPERAND + globalIndex(name);
+}
+
+uint32_t Compiler::loadName(const std::string& name, uint32_t dst) {
+    // A name that a def binds (or a builtin's) evaluates to the function
+    // while one by that name exists
+    if (functionNames.count(name) || isBuiltinFunction(name)) {
+        uint32_t result = dst == ANY ? allocateRegister() : dst;
+        emit(Opcode::LOAD_CALLABLE, result, globalIndex(name));
+        return result;
+    }
+    return moveTo(variable(name, dst), dst);
+}
+
+uint32_t Compiler::storeOperand(const std::string& name) {
+    // According to the grammar: "the only way for local variables to override
+    // global variables is through the function parameter list"
+    auto param = unit.params.find(name);
+    return param != unit.params.end() ? param->second : GLOBAL_OPERAND + globalIndex(name);
+}
+
+void Compiler::branchIfFalse(antlr4::tree::ParseTree* tree, std::vector<size_t>& jumps) {
+    if (const Value* value = constant(tree)) {
+        if (!value->toBool()) {
+            jumps.push_back(emit(Opcode::JUMP));
+        }
+        return;
+    }
+
+    // Each operand of an and branches on its own
+    auto andTest = dynamic_cast<Python3Parser::And_testContext*>(tree);
+    if (andTest && andTest->not_test().size() > 1) {
+        for (auto notTest : andTest->not_test()) {
+            branchIfFalse(notTest, jumps);
+        }
+        return;
+    }
+
+    // compare-and-branch: each link jumps itself instead of storing a bool
+    // for a branch to test
+    auto comparison = dynamic_cast<Python3Parser::ComparisonContext*>(tree);
+    if (comparison && comparison->children.size() > 1) {
+        const auto& children = comparison->children;
+        uint32_t left = evaluate(children[0]);
+        for (size_t i = 1; i + 1 < children.size(); i += 2) {
+            left = snapshot(left, children[i + 1]);
+            uint32_t right = evaluate(children[i + 1]);
+            if (i + 2 < children.size()) {
+                right = snapshot(right, children[i + 3]);
+            }
+            CompareOp op = compareOp(children[i]->getText());
+            bool ints = isInt(staticType(children[i - 1]), staticType(children[i + 1]));
+            jumps.push_back(emit(compareOpcode(op, ints), 0, left, right, (uint8_t)op | BRANCH_IF_FALSE));
+            left = right;
+        }
+        return;
+    }
+
+    // test, or_test and the like around a single operand
+    if (tree->children.size() == 1 && !dynamic_cast<antlr4::tree::TerminalNode*>(tree->children[0])) {
+        branchIfFalse(tree->children[0], jumps);
+        return;
+    }
+    jumps.push_back(emit(Opcode::JUMP_IF_FALSE, 0, evaluate(tree)));
+}
+
+void Compiler::emitLineExits(size_t openLines) {
+    for (size_t i = openLines; i < unit.openLines; i++) {
+        emit(Opcode::LINE_EXIT);
+    }
+}
+
+void Compiler::bindLabel(size_t jump) {
+    unit.code->instructions[jump].a = here();
+}
+
+void Compiler::bindLabels(const std::vector<size_t>& jumps) {
+    for (size_t jump : jumps) {
+        bindLabel(jump);
+    }
+}
+
+size_t Compiler::here() {
+    return unit.code->instructions.size();
+}
+
+uint32_t Compiler::emitOperators(antlr4::ParserRuleContext* ctx) {
+    auto hoisted = unit.hoisted.find(ctx);
+    if (hoisted != unit.hoisted.end()) {
+        return moveTo(hoisted->second, target);
+    }
+    const auto& children = ctx->children;
+    if (children.size() == 1) {
+        return std::any_cast<uint32_t>(visit(children[0]));
+    }
+    uint32_t dst = target;
+    if (const Value* value = constant(ctx)) {
+        return moveTo(constantOperand(*value), dst);
+    }
+
+    // Intermediate results stay in temporaries: only the last operator
+    // writes the target, which a later operand may still read
+    uint32_t left = evaluate(children[0]);
+    StaticType leftType = staticType(children[0]);
+    for (size_t i = 1; i + 1 < children.size(); i += 2) {
+        left = snapshot(left, children[i + 1]);
+        uint32_t right = evaluate(children[i + 1]);
+        StaticType rightType = staticType(children[i + 1]);
+        uint32_t result;
+        if (i + 2 >= children.size() && dst != ANY) {
+            result = dst;
+        } else if (isRegister(left) && left >= unit.firstTemporary) {
+            result = left;
+        } else {
+            result = allocateRegister();
+        }
+        BinaryOp op = binaryOp(children[i]->getText());
+        emit(binaryOpcode(op, isInt(leftType, rightType)), result, left, right, (uint8_t)op);
+        left = result;
+        leftType = binaryType(op, leftType, rightType);
+    }
+    return left;
+}
+
+const Value* Compiler::constant(antlr4::tree::ParseTree* tree) {
+    auto found = constants.find(tree);
+    if (found != constants.end()) {
+        return found->second;
+    }
+    const Value* value = fold(tree);
+    constants.emplace(tree, value);
+    return value;
+}
+
+const Value* Compiler::fold(antlr4::tree::ParseTree* tree) {
+    if (auto atom = dynamic_cast<Python3Parser::AtomContext*>(tree)) {
+        if (atom->NAME() || atom->format_string()) {
+            return nullptr;
+        }
+        if (atom->test()) {
+            return constant(atom->test());
+        }
+        if (atom->TRUE()) {
+            return storeFolded(Value::Bool(true));
+        }
+        if (atom->FALSE()) {
+            return storeFolded(Value::Bool(false));
+        }
+        if (atom->NUMBER()) {
+            std::string numStr = atom->NUMBER()->getText();
+            if (numStr.find('.') != std::string::npos) {
+                return storeFolded(Value::Float(std::stod(numStr)));
+            }
+            return storeFolded(Value::Int(BigInteger(numStr)));
+        }
+        if (!atom->STRING().empty()) {
+            std::string result;
+            for (auto str : atom->STRING()) {
+                std::string s = str->getText();
+                // Remove quotes
+                result += s.substr(1, s.length() - 2);
+            }
+            return storeFolded(Value::String(result));
+        }
+        return storeFolded(Value::None());
+    }
+    if (auto atomExpr = dynamic_cast<Python3Parser::Atom_exprContext*>(tree)) {
+        return atomExpr->trailer() ? nullptr : constant(atomExpr->atom());
+    }
+    if (auto factor = dynamic_cast<Python3Parser::FactorContext*>(tree)) {
+        if (!factor->factor()) {
+            return constant(factor->atom_expr());
+        }
+        const Value* operand = constant(factor->factor());
+        if (!operand) {
+            return nullptr;
+        }
+        Value value = *operand;
+        if (factor->MINUS()) {
+            if (value.type == ValueType::INT) {
+                value.intVal.negate();
+            } else if (value.type == ValueType::FLOAT) {
+                value.floatVal = -value.floatVal;
+            }
+        }
+        return storeFolded(std::move(value));
+    }
+    if (dynamic_cast<Python3Parser::TermContext*>(tree) || dynamic_cast<Python3Parser::Arith_exprContext*>(tree) ||
+        dynamic_cast<Python3Parser::ComparisonContext*>(tree)) {
+        return foldOperators(static_cast<antlr4::ParserRuleContext*>(tree));
+    }
+    if (auto notTest = dynamic_cast<Python3Parser::Not_testContext*>(tree)) {
+        if (!notTest->NOT()) {
+            return constant(notTest->comparison());
+        }
+        const Value* operand = constant(notTest->not_test());
+        return operand ? storeFolded(Value::Bool(!operand->toBool())) : nullptr;
+    }
+    if (auto andTest = dynamic_cast<Python3Parser::And_testContext*>(tree)) {
+        return foldShortCircuit(andTest->not_test(), false);
+    }
+    if (auto orTest = dynamic_cast<Python3Parser::Or_testContext*>(tree)) {
+        return foldShortCircuit(orTest->and_test(), true);
+    }
+
+    // Anything else only passes a lone constant child through (test and
+    // the like)
+    if (tree->children.size() == 1 && !dynamic_cast<antlr4::tree::TerminalNode*>(tree->children[0])) {
+        return constant(tree->children[0]);
+    }
+    return nullptr;
+}
+
+const Value* Compiler::foldOperators(antlr4::ParserRuleContext* ctx) {
+    const auto& children = ctx->children;
+    if (children.size() == 1) {
+        return constant(children[0]);
+    }
+
+    for (size_t i = 0; i < children.size(); i += 2) {
+        if (!constant(children[i])) {
+            return nullptr;
+        }
+    }
+
+    // Operand errors such as a zero divisor are left to surface at run time
+    try {
+        Value result = *constant(children[0]);
+        if (dynamic_cast<Python3Parser::ComparisonContext*>(ctx)) {
+            for (size_t i = 1; i + 1 < children.size(); i += 2) {
+                const Value& right = *constant(children[i + 1]);
+                if (!performCompare(compareOp(children[i]->getText()), result, right)) {
+                    return storeFolded(Value::Bool(false));
+                }
+                result = right;
+            }
+            return storeFolded(Value::Bool(true));
+        }
+        for (size_t i = 1; i + 1 < children.size(); i += 2) {
+            const Value& right = *constant(children[i + 1]);
+            BinaryOp op = binaryOp(children[i]->getText());
+            if (op == BinaryOp::MUL && !repetitionFits(result, right)) {
+                return nullptr;
+            }
+            if (!performInPlace(result, right, op)) {
+                result = performBinary(op, result, right);
+            }
+        }
+        return storeFolded(std::move(result));
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+template <typename Operand>
+const Value* Compiler::foldShortCircuit(const std::vector<Operand*>& operands, bool stopWhen) {
+    // The value is that of the first operand whose truth ends the and (or
+    // or), or of the last; operands after it never run, so they need not
+    // be constant
+    for (size_t i = 0; i < operands.size(); i++) {
+        const Value* operand = constant(operands[i]);
+        if (!operand || operand->toBool() == stopWhen || i + 1 == operands.size()) {
+            return operand;
+        }
+    }
+    return nullptr;
+}
+
+const Value* Compiler::storeFolded(Value value) {
+    foldedValues.push_back(std::move(value));
+    return &foldedValues.back();
+}
+
+Compiler::StaticType Compiler::staticType(antlr4::tree::ParseTree* tree) {
+    if (const Value* value = constant(tree)) {
+        switch (value->type) {
+            case ValueType::INT:
+                return StaticType::INT;
+            case ValueType::FLOAT:
+                return StaticType::FLOAT;
+            case ValueType::STRING:
+                return StaticType::STRING;
+            case ValueType::BOOL:
+                return StaticType::BOOL;
+            default:
+                return StaticType::UNKNOWN;
+        }
+    }
+    if (auto atom = dynamic_cast<Python3Parser::AtomContext*>(tree)) {
+        if (atom->NAME()) {
+            // A parameter named like a function loads the function instead
+            std::string name = atom->NAME()->getText();
+            bool callable = functionNames.count(name) || isBuiltinFunction(name);
+            return unit.intParams.count(name) && !callable ? StaticType::INT : StaticType::UNKNOWN;
+        }
+        if (atom->format_string()) {
+            return StaticType::STRING;
+        }
+        return atom->test() ? staticType(atom->test()) : StaticType::UNKNOWN;
+    }
+    if (auto atomExpr = dynamic_cast<Python3Parser::Atom_exprContext*>(tree)) {
+        if (!atomExpr->trailer()) {
+            return staticType(atomExpr->atom());
+        }
+        // The builtin conversions always win over a def of the same name,
+        // and return None only when given no positional argument
+        auto arglist = atomExpr->trailer()->arglist();
+        if (!atomExpr->atom()->NAME() || !arglist || arglist->argument(0)->test().size() != 1) {
+            return StaticType::UNKNOWN;
+        }
+        std::string name = atomExpr->atom()->NAME()->getText();
+        if (name == "int") return StaticType::INT;
+        if (name == "float") return StaticType::FLOAT;
+        if (name == "str") return StaticType::STRING;
+        if (name == "bool") return StaticType::BOOL;
+        return StaticType::UNKNOWN;
+    }
+    if (auto factor = dynamic_cast<Python3Parser::FactorContext*>(tree)) {
+        if (!factor->factor()) {
+            return staticType(factor->atom_expr());
+        }
+        // NEGATE leaves bools alone, so only numbers keep their type
+        StaticType operand = staticType(factor->factor());
+        return operand == StaticType::INT || operand == StaticType::FLOAT ? operand : StaticType::UNKNOWN;
+    }
+    if (dynamic_cast<Python3Parser::TermContext*>(tree) || dynamic_cast<Python3Parser::Arith_exprContext*>(tree)) {
+        const auto& children = tree->children;
+        StaticType type = staticType(children[0]);
+        for (size_t i = 1; i + 1 < children.size(); i += 2) {
+            type = binaryType(binaryOp(children[i]->getText()), type, staticType(children[i + 1]));
+        }
+        return type;
+    }
+    if (auto comparison = dynamic_cast<Python3Parser::ComparisonContext*>(tree)) {
+        return comparison->children.size() > 1 ? StaticType::BOOL : staticType(comparison->children[0]);
+    }
+    if (auto notTest = dynamic_cast<Python3Parser::Not_testContext*>(tree)) {
+        return notTest->NOT() ? StaticType::BOOL : staticType(notTest->comparison());
+    }
+
+    // test, or_test and the like around a single operand; and and or give
+    // one of their operands, which may differ in type
+    if (tree->children.size() == 1 && !dynamic_cast<antlr4::tree::TerminalNode*>(tree->children[0])) {
+        return staticType(tree->children[0]);
+    }
+    return StaticType::UNKNOWN;
+}
+
+Compiler::StaticType Compiler::binaryType(BinaryOp op, StaticType left, StaticType right) {
+    if (isInt(left, right)) {
+        return op == BinaryOp::DIV ? StaticType::FLOAT : StaticType::INT;
+    }
+    bool leftNumber = left == StaticType::INT || left == StaticType::FLOAT;
+    bool rightNumber = right == StaticType::INT || right == StaticType::FLOAT;
+    if (leftNumber && rightNumber) {
+        return StaticType::FLOAT;
+    }
+    if (op == BinaryOp::ADD && left == StaticType::STRING && right == StaticType::STRING) {
+        return StaticType::STRING;
+    }
+    return StaticType::UNKNOWN;
+}
+
+std::unordered_set<std::string> Compiler::intParameters(Python3Parser::FuncdefContext* ctx,
+                                                        const FunctionCode& function) {
+    std::vector<Store> stores;
+    collectStores(ctx->suite(), stores);
+
+    // Start from the parameters some operator works on, since checking the
+    // others would only turn calls away, and drop those some assignment may
+    // store something else to, until the rest agree
+    std::unordered_set<std::string> operands;
+    collectOperands(ctx->suite(), operands, false);
+    std::unordered_set<std::string> enclosing = std::move(unit.intParams);
+    unit.intParams.clear();
+    for (const std::string& param : function.params) {
+        if (operands.count(param)) {
+            unit.intParams.insert(param);
+        }
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (const Store& store : stores) {
+            if (!unit.intParams.count(store.name)) {
+                continue;
+            }
+            StaticType type = store.value ? staticType(store.value) : StaticType::UNKNOWN;
+            if (store.augmented) {
+                type = binaryType(store.op, StaticType::INT, type);
+            }
+            if (type != StaticType::INT) {
+                unit.intParams.erase(store.name);
+                changed = true;
+            }
+        }
+    }
+    std::unordered_set<std::string> intParams = std::move(unit.intParams);
+    unit.intParams = std::move(enclosing);
+    return intParams;
+}
+
+void Compiler::collectStores(antlr4::tree::ParseTree* tree, std::vector<Store>& stores) {
+    auto exprStmt = dynamic_cast<Python3Parser::Expr_stmtContext*>(tree);
+    if (!exprStmt) {
+        for (auto child : tree->children) {
+            collectStores(child, stores);
+        }
+        return;
+    }
+
+    // Mirrors visitExpr_stmt: an augmented assignment updates its single
+    // target, a lone value for several targets is a tuple to unpack, and
+    // otherwise each target list takes the values element by element
+    auto testlists = exprStmt->testlist();
+    if (testlists.size() == 1) {
+        return;
+    }
+    if (exprStmt->augassign()) {
+        auto targets = testlists[0]->test();
+        if (targets.size() == 1) {
+            std::string text = exprStmt->augassign()->getText();
+            text.pop_back();
+            stores.push_back(Store{targets[0]->getText(), testlists[1]->test(0), true, binaryOp(text)});
+        }
+        return;
+    }
+    auto values = testlists.back()->test();
+    for (size_t i = 0; i + 1 < testlists.size(); i++) {
+        auto targets = testlists[i]->test();
+        for (size_t j = 0; j < targets.size(); j++) {
+            if (targets.size() > 1 && values.size() == 1) {
+                stores.push_back(Store{targets[j]->getText(), nullptr, false, BinaryOp::ADD});
+            } else if (j < values.size()) {
+                stores.push_back(Store{targets[j]->getText(), values[j], false, BinaryOp::ADD});
+            }
+        }
+    }
+}
+
+void Compiler::collectOperands(antlr4::tree::ParseTree* tree, std::unordered_set<std::string>& names,
+                               bool operand) {
+    if (dynamic_cast<Python3Parser::TrailerContext*>(tree)) {
+        operand = false;  // call arguments are the callee's business
+    } else if (dynamic_cast<Python3Parser::TermContext*>(tree) || dynamic_cast<Python3Parser::Arith_exprContext*>(tree) ||
+               dynamic_cast<Python3Parser::ComparisonContext*>(tree)) {
+        operand = operand || tree->children.size() > 1;
+    } else if (auto exprStmt = dynamic_cast<Python3Parser::Expr_stmtContext*>(tree)) {
+        operand = operand || exprStmt->augassign() != nullptr;
+    } else if (auto atom = dynamic_cast<Python3Parser::AtomContext*>(tree)) {
+        if (operand && atom->NAME()) {
+            names.insert(atom->NAME()->getText());
+        }
+    }
+    for (auto child : tree->children) {
+        collectOperands(child, names, operand);
+    }
+}
+
+void Compiler::markPureFunctions(antlr4::tree::ParseTree* file) {
+    // A call to a def's name reads the variable of that name while no such
+    // def exists, so only names no assignment in the program binds are
+    // known to call the def
+    std::vector<Store> stores;
+    collectStores(file, stores);
+    std::unordered_set<std::string> callable = functionNames;
+    for (const Store& store : stores) {
+        callable.erase(store.name);
+    }
+
+    std::vector<std::unordered_set<std::string>> callees(program.functions.size());
+    std::vector<bool> pure(program.functions.size());
+    for (size_t i = 0; i < program.functions.size(); i++) {
+        const std::vector<std::string>& params = program.functions[i].params;
+        pure[i] = isPure(funcdefs[i]->suite(), {params.begin(), params.end()}, callable, callees[i]);
+    }
+
+    // A def stays pure while every def by the name of a callee does
+    std::unordered_map<std::string, std::vector<size_t>> byName;
+    for (size_t i = 0; i < program.functions.size(); i++) {
+        byName[program.functions[i].name].push_back(i);
+    }
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t i = 0; i < program.functions.size(); i++) {
+            if (!pure[i]) {
+                continue;
+            }
+            for (const std::string& callee : callees[i]) {
+                for (size_t j : byName[callee]) {
+                    if (!pure[j]) {
+                        pure[i] = false;
+                        changed = true;
+                    }
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < program.functions.size(); i++) {
+        program.functions[i].pure = pure[i];
+    }
+}
+
+bool Compiler::isPure(antlr4::tree::ParseTree* tree, const std::unordered_set<std::string>& params,
+                      const std::unordered_set<std::string>& callable, std::unordered_set<std::string>& callees) {
+    if (dynamic_cast<Python3Parser::FuncdefContext*>(tree)) {
+        return false;
+    }
+    if (auto exprStmt = dynamic_cast<Python3Parser::Expr_stmtContext*>(tree)) {
+        auto testlists = exprStmt->testlist();
+        for (size_t i = 0; i + 1 < testlists.size(); i++) {
+            for (auto target : testlists[i]->test()) {
+                if (!params.count(target->getText())) {
+                    return false;
+                }
+            }
+        }
+    } else if (auto atomExpr = dynamic_cast<Python3Parser::Atom_exprContext*>(tree)) {
+        if (atomExpr->trailer()) {
+            // Only the arguments are evaluated; the callee is looked up
+            auto callee = atomExpr->atom()->NAME();
+            if (!callee) {
+                return false;
+            }
+            std::string name = callee->getText();
+            if (name == "print") {
+                return false;
+            }
+            if (!isBuiltinFunction(name)) {
+                if (!callable.count(name)) {
+                    return false;
+                }
+                callees.insert(name);
+            }
+            return isPure(atomExpr->trailer(), params, callable, callees);
+        }
+    } else if (auto atom = dynamic_cast<Python3Parser::AtomContext*>(tree)) {
+        // A parameter named like a function loads the function instead
+        if (atom->NAME()) {
+            std::string name = atom->NAME()->getText();
+            return params.count(name) && !functionNames.count(name) && !isBuiltinFunction(name);
+        }
+    }
+    for (auto child : tree->children) {
+        if (!isPure(child, params, callable, callees)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Compiler::collectInvariants(Python3Parser::While_stmtContext* ctx,
+                                 std::vector<antlr4::tree::ParseTree*>& conditionInvariants,
+                                 std::vector<antlr4::tree::ParseTree*>& bodyInvariants) {
+    LoopEffects effects;
+    std::vector<Store> stores;
+    collectStores(ctx->suite(), stores);
+    for (const Store& store : stores) {
+        effects.assigned.insert(store.name);
+    }
+    effects.callsDef = callsDef(ctx);
+
+    // Only what every pass evaluates counts: the condition, and the body's
+    // own simple statements up to the first statement that may break,
+    // continue or return. Nested blocks may not run at all.
+    collectInvariants(ctx->test(), effects, conditionInvariants);
+    auto suite = ctx->suite();
+    if (suite->simple_stmt()) {
+        if (!containsJump(suite->simple_stmt())) {
+            collectInvariants(suite->simple_stmt(), effects, bodyInvariants);
+        }
+        return;
+    }
+    for (auto stmt : suite->stmt()) {
+        if (containsJump(stmt)) {
+            break;
+        }
+        if (stmt->simple_stmt()) {
+            collectInvariants(stmt->simple_stmt(), effects, bodyInvariants);
+        }
+    }
+}
+
+void Compiler::hoist(const std::vector<antlr4::tree::ParseTree*>& invariants) {
+    for (auto tree : invariants) {
+        uint32_t value = allocateRegister();
+        evaluate(tree, value);
+        unit.freeRegister = value + 1;
+        unit.hoisted.emplace(tree, value);
+    }
+}
+
+void Compiler::collectInvariants(antlr4::tree::ParseTree* tree, const LoopEffects& effects,
+                                 std::vector<antlr4::tree::ParseTree*>& invariants) {
+    // The largest invariant expressions are taken whole
+    bool operators = dynamic_cast<Python3Parser::TermContext*>(tree) ||
+                     dynamic_cast<Python3Parser::Arith_exprContext*>(tree);
+    if (operators && tree->children.size() > 1 && !constant(tree) && !unit.hoisted.count(tree) &&
+        isInvariant(tree, effects)) {
+        invariants.push_back(tree);
+        return;
+    }
+
+    // Operands after the first of and and or, and after the first link of
+    // a chained comparison, are not evaluated when it decides the result
+    size_t evaluated = tree->children.size();
+    if (dynamic_cast<Python3Parser::And_testContext*>(tree) || dynamic_cast<Python3Parser::Or_testContext*>(tree)) {
+        evaluated = 1;
+    } else if (dynamic_cast<Python3Parser::ComparisonContext*>(tree)) {
+        evaluated = std::min<size_t>(evaluated, 3);
+    }
+    for (size_t i = 0; i < evaluated; i++) {
+        collectInvariants(tree->children[i], effects, invariants);
+    }
+}
+
+bool Compiler::isInvariant(antlr4::tree::ParseTree* tree, const LoopEffects& effects) {
+    if (constant(tree)) {
+        return true;
+    }
+    if (auto atom = dynamic_cast<Python3Parser::AtomContext*>(tree)) {
+        if (atom->NAME()) {
+            // Names of functions load whatever def is bound at the time
+            std::string name = atom->NAME()->getText();
+            if (functionNames.count(name) || isBuiltinFunction(name) || effects.assigned.count(name)) {
+                return false;
+            }
+            return !effects.callsDef || unit.params.count(name);
+        }
+        return atom->test() && isInvariant(atom->test(), effects);
+    }
+    if (auto atomExpr = dynamic_cast<Python3Parser::Atom_exprContext*>(tree)) {
+        return !atomExpr->trailer() && isInvariant(atomExpr->atom(), effects);
+    }
+    if (auto factor = dynamic_cast<Python3Parser::FactorContext*>(tree)) {
+        return factor->factor() ? isInvariant(factor->factor(), effects) : isInvariant(factor->atom_expr(), effects);
+    }
+    if (dynamic_cast<Python3Parser::TermContext*>(tree) || dynamic_cast<Python3Parser::Arith_exprContext*>(tree)) {
+        const auto& children = tree->children;
+        for (size_t i = 0; i < children.size(); i += 2) {
+            if (!isInvariant(children[i], effects)) {
+                return false;
+            }
+        }
+        // Only a zero divisor makes an operator fail, which must not happen
+        // before the statements ahead of it have run
+        for (size_t i = 1; i + 1 < children.size(); i += 2) {
+            BinaryOp op = binaryOp(children[i]->getText());
+            if (op == BinaryOp::DIV || op == BinaryOp::FLOORDIV || op == BinaryOp::MOD) {
+                const Value* divisor = constant(children[i + 1]);
+                if (!divisor || !divisor->toBool()) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // test, or_test and the like around a single operand
+    return tree->children.size() == 1 && !dynamic_cast<antlr4::tree::TerminalNode*>(tree->children[0]) &&
+           isInvariant(tree->children[0], effects);
+}
+
+bool Compiler::containsCall(antlr4::tree::ParseTree* tree) {
+    if (dynamic_cast<Python3Parser::TrailerContext*>(tree)) {
+        return true;
+    }
+    for (auto child : tree->children) {
+        if (containsCall(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Compiler::callsDef(antlr4::tree::ParseTree* tree) {
+    // Builtins win over defs of the same name
+    auto atomExpr = dynamic_cast<Python3Parser::Atom_exprContext*>(tree);
+    if (atomExpr && atomExpr->trailer() &&
+        (!atomExpr->atom()->NAME() || !isBuiltinFunction(atomExpr->atom()->NAME()->getText()))) {
+        return true;
+    }
+    for (auto child : tree->children) {
+        if (callsDef(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Compiler::containsJump(antlr4::tree::ParseTree* tree) {
+    if (dynamic_cast<Python3Parser::Break_stmtContext*>(tree) ||
+        dynamic_cast<Python3Parser::Continue_stmtContext*>(tree) ||
+        dynamic_cast<Python3Parser::Return_stmtContext*>(tree)) {
+        return true;
+    }
+    for (auto child : tree->children) {
+        if (containsJump(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Compiler::isCall(antlr4::tree::ParseTree* tree) {
+    // test, or_test and the like around a lone atom_expr
+    while (tree->children.size() == 1 && !dynamic_cast<Python3Parser::Atom_exprContext*>(tree)) {
+        tree = tree->children[0];
+    }
+    auto atomExpr = dynamic_cast<Python3Parser::Atom_exprContext*>(tree);
+    return atomExpr && atomExpr->trailer();
+}
+
+bool Compiler::containsFuncdef(antlr4::tree::ParseTree* tree) {
+    if (dynamic_cast<Python3Parser::FuncdefContext*>(tree)) {
+        return true;
+    }
+    for (auto child : tree->children) {
+        if (containsFuncdef(child)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+BinaryOp Compiler::binaryOp(const std::string& text) {
+    if (text == "+") return BinaryOp::ADD;
+    if (text == "-") return BinaryOp::SUB;
+    if (text == "*") return BinaryOp::MUL;
+    if (text == "/") return BinaryOp::DIV;
+    if (text == "//") return BinaryOp::FLOORDIV;
+    if (text == "%") return BinaryOp::MOD;
+    throw std::runtime_error("unknown operator " + text);
+}
+
+CompareOp Compiler::compareOp(const std::string& text) {
+    if (text == "<") return CompareOp::LT;
+    if (text == ">") return CompareOp::GT;
+    if (text == "<=") return CompareOp::LE;
+    if (text == ">=") return CompareOp::GE;
+    if (text == "==") return CompareOp::EQ;
+    if (text == "!=") return CompareOp::NE;
+    throw std::runtime_error("unknown comparison " + text);
+}
@@ -0,0 +1,201 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_COMPILER_H
+#define PYTHON_INTERPRETER_COMPILER_H
+
+#include "Bytecode.h"
+#include "Python3ParserBaseVisitor.h"
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Translates the parse tree into code objects for the virtual machine: one
+// for the module and one per def. Expression visits compile into the
+// operand in target, or into any operand when target is ANY, and return the
+// operand holding the value: a parameter's register, a global, a constant or
+// a temporary register. Temporaries are allocated above the parameters in
+// stack order and released after each statement. Expressions whose operands
+// are all literals are folded into constants here. A def whose parameters
+// stay ints whenever they are passed ints is also compiled a second time
+// assuming they are, so that operators over them, literals and int() need
+// no type checks. Arithmetic a while loop would recompute on every pass
+// from operands it cannot change is computed once before it.
+class Compiler : public Python3ParserBaseVisitor {
+public:
+    explicit Compiler(Program& program) : program(program) {}
+
+    std::any visitFile_input(Python3Parser::File_inputContext *ctx) override;
+    std::any visitFuncdef(Python3Parser::FuncdefContext *ctx) override;
+    std::any visitStmt(Python3Parser::StmtContext *ctx) override;
+    std::any visitExpr_stmt(Python3Parser::Expr_stmtContext *ctx) override;
+    std::any visitBreak_stmt(Python3Parser::Break_stmtContext *ctx) override;
+    std::any visitContinue_stmt(Python3Parser::Continue_stmtContext *ctx) override;
+    std::any visitReturn_stmt(Python3Parser::Return_stmtContext *ctx) override;
+    std::any visitIf_stmt(Python3Parser::If_stmtContext *ctx) override;
+    std::any visitWhile_stmt(Python3Parser::While_stmtContext *ctx) override;
+    std::any visitSuite(Python3Parser::SuiteContext *ctx) override;
+    std::any visitOr_test(Python3Parser::Or_testContext *ctx) override;
+    std::any visitAnd_test(Python3Parser::And_testContext *ctx) override;
+    std::any visitNot_test(Python3Parser::Not_testContext *ctx) override;
+    std::any visitComparison(Python3Parser::ComparisonContext *ctx) override;
+    std::any visitArith_expr(Python3Parser::Arith_exprContext *ctx) override;
+    std::any visitTerm(Python3Parser::TermContext *ctx) override;
+    std::any visitFactor(Python3Parser::FactorContext *ctx) override;
+    std::any visitAtom_expr(Python3Parser::Atom_exprContext *ctx) override;
+    std::any visitAtom(Python3Parser::AtomContext *ctx) override;
+    std::any visitFormat_string(Python3Parser::Format_stringContext *ctx) override;
+
+private:
+    Program& program;
+
+    static constexpr uint32_t ANY = UINT32_MAX;
+
+    struct Loop {
+        size_t start;
+        std::vector<size_t> breaks;
+        size_t openLines;
+    };
+
+    // State of the code object being emitted; a def saves and restores it
+    struct Unit {
+        CodeObject* code = nullptr;
+        // The def's parameters and their registers; empty for the module
+        std::unordered_map<std::string, uint32_t> params;
+        bool isFunction = false;
+        // Parameters the code may assume hold ints: those the call checks
+        // before entering a def's int-specialized version
+        std::unordered_set<std::string> intParams;
+        uint32_t freeRegister = 0;
+        // Registers from here up are temporaries; those below hold the
+        // parameters and the values hoisted out of the loops being compiled
+        uint32_t firstTemporary = 0;
+        std::unordered_map<antlr4::tree::ParseTree*, uint32_t> hoisted;
+        // LINE_ENTERs not yet matched by a LINE_EXIT, which break, continue
+        // and return emit on their way out
+        size_t openLines = 0;
+        std::vector<Loop> loops;
+    };
+    Unit unit;
+    uint32_t target = ANY;
+    bool profileLines = false;
+
+    // Names some def binds, whose loads must check for a function first
+    std::unordered_set<std::string> functionNames;
+    // Names some def takes as a parameter. Inside a def, reading one that
+    // is not its own parameter may find an outer call's, so it is looked up
+    // when it runs; every other variable is a global operand.
+    std::unordered_set<std::string> parameterNames;
+    std::unordered_map<std::string, uint32_t> globalIndices;
+    void collectNames(antlr4::tree::ParseTree* tree);
+
+    // Compiles a def's body into a new code object, with intParams assumed
+    // to hold ints
+    CodeObject* compileBody(Python3Parser::FuncdefContext* ctx, const FunctionCode& function,
+                            std::unordered_set<std::string> intParams);
+
+    size_t emit(Opcode op, uint32_t a = 0, uint32_t b = 0, uint32_t c = 0, uint8_t sub = 0);
+    uint32_t globalIndex(const std::string& name);
+    uint32_t constantOperand(const Value& value);
+    uint32_t allocateRegister();
+    // Compiles tree into dst (or anywhere for ANY) and returns its operand
+    uint32_t evaluate(antlr4::tree::ParseTree* tree, uint32_t dst = ANY);
+    // Compiles each tree into consecutive fresh registers; returns the first
+    uint32_t evaluateConsecutive(const std::vector<antlr4::tree::ParseTree*>& trees);
+    // Copies result to dst unless it is already there or dst is ANY
+    uint32_t moveTo(uint32_t result, uint32_t dst);
+    // Copies a global operand to a temporary when later code could call a
+    // function that rebinds it before it is used
+    uint32_t snapshot(uint32_t operand, antlr4::tree::ParseTree* later);
+    // The operand a read of variable name uses, loading it into dst (or a
+    // temporary) when it must be looked up at run time
+    uint32_t variable(const std::string& name, uint32_t dst = ANY);
+    uint32_t loadName(const std::string& name, uint32_t dst);
+    uint32_t storeOperand(const std::string& name);
+    // Emits jumps taken when tree is false, for bindLabels to fill in
+    void branchIfFalse(antlr4::tree::ParseTree* tree, std::vector<size_t>& jumps);
+    void emitLineExits(size_t openLines);
+    void bindLabel(size_t jump);
+    void bindLabels(const std::vector<size_t>& jumps);
+    size_t here();
+    uint32_t emitOperators(antlr4::ParserRuleContext* ctx);
+
+    // Constant folding: the value of an expression whose operands are all
+    // literals, or nullptr. Memoized per node, so nested expressions are
+    // folded once.
+    std::unordered_map<antlr4::tree::ParseTree*, const Value*> constants;
+    std::deque<Value> foldedValues;
+    const Value* constant(antlr4::tree::ParseTree* tree);
+    const Value* fold(antlr4::tree::ParseTree* tree);
+    const Value* foldOperators(antlr4::ParserRuleContext* ctx);
+    template <typename Operand>
+    const Value* foldShortCircuit(const std::vector<Operand*>& operands, bool stopWhen);
+    const Value* storeFolded(Value value);
+
+    // Static types, as far as literals, int-typed parameters and the
+    // builtin conversions tell; UNKNOWN for whatever a global, a call or an
+    // operator on unknown operands could be
+    enum class StaticType : uint8_t { UNKNOWN, INT, FLOAT, STRING, BOOL };
+    StaticType staticType(antlr4::tree::ParseTree* tree);
+    static StaticType binaryType(BinaryOp op, StaticType left, StaticType right);
+    static bool isInt(StaticType left, StaticType right) {
+        return left == StaticType::INT && right == StaticType::INT;
+    }
+
+    // The parameters of a def that hold ints throughout a call that passes
+    // them ints: every assignment to one in the body stores an int, given
+    // that the others are ints too
+    std::unordered_set<std::string> intParameters(Python3Parser::FuncdefContext* ctx, const FunctionCode& function);
+    struct Store {
+        std::string name;
+        // The value stored, or null when it is not known, such as an
+        // element of an unpacked tuple
+        antlr4::tree::ParseTree* value;
+        // For augmented assignment, the operator applied to the old value
+        bool augmented;
+        BinaryOp op;
+    };
+    static void collectStores(antlr4::tree::ParseTree* tree, std::vector<Store>& stores);
+    // Names read as operands of an arithmetic or comparison operator
+    static void collectOperands(antlr4::tree::ParseTree* tree, std::unordered_set<std::string>& names, bool operand);
+
+    // Purity: the defs, in program.functions order, are marked pure once
+    // the whole file is compiled, since a def may call one defined later
+    std::vector<Python3Parser::FuncdefContext*> funcdefs;
+    void markPureFunctions(antlr4::tree::ParseTree* file);
+    // Whether tree reads and assigns only params and calls only conversions
+    // and defs named in callable, which collects the defs it calls
+    bool isPure(antlr4::tree::ParseTree* tree, const std::unordered_set<std::string>& params,
+                const std::unordered_set<std::string>& callable, std::unordered_set<std::string>& callees);
+
+    // Loop-invariant code motion: arithmetic that cannot fail, that every
+    // pass of a while loop evaluates and whose operands the loop does not
+    // assign is evaluated once into registers, before the loop for the
+    // condition's and after its first test for the body's. With a call of
+    // a def in the loop, any global may change, so then only the def's own
+    // parameters count.
+    struct LoopEffects {
+        std::unordered_set<std::string> assigned;
+        bool callsDef;
+    };
+    void collectInvariants(Python3Parser::While_stmtContext* ctx,
+                           std::vector<antlr4::tree::ParseTree*>& conditionInvariants,
+                           std::vector<antlr4::tree::ParseTree*>& bodyInvariants);
+    void collectInvariants(antlr4::tree::ParseTree* tree, const LoopEffects& effects,
+                           std::vector<antlr4::tree::ParseTree*>& invariants);
+    bool isInvariant(antlr4::tree::ParseTree* tree, const LoopEffects& effects);
+    void hoist(const std::vector<antlr4::tree::ParseTree*>& invariants);
+
+    static bool containsCall(antlr4::tree::ParseTree* tree);
+    // Whether tree calls anything but a builtin
+    static bool callsDef(antlr4::tree::ParseTree* tree);
+    // Whether tree holds a break, continue or return
+    static bool containsJump(antlr4::tree::ParseTree* tree);
+    static bool containsFuncdef(antlr4::tree::ParseTree* tree);
+    // Whether tree is nothing but a call
+    static bool isCall(antlr4::tree::ParseTree* tree);
+    static BinaryOp binaryOp(const std::string& text);
+    static CompareOp compareOp(const std::string& text);
+};
+
+#endif//PYTHON_INTERPRETER_COMPILER_H
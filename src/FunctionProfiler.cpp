@@ -0,0 +1,144 @@
+#include "FunctionProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <unordered_map>
+#include <vector>
+
+bool FunctionProfiler::active = false;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct FunctionTotals {
+    std::string name;
+    uint64_t calls = 0;
+    Clock::duration inclusive{};
+    int activeCalls = 0;
+};
+
+// Node of the calling context tree: one per distinct chain of callers.
+// Node 0 is the root, above the outermost call.
+struct ContextNode {
+    size_t function;
+    size_t parent;
+    std::vector<size_t> children;
+    uint64_t calls = 0;
+    Clock::duration inclusive{};
+    Clock::duration childTime{};
+};
+
+struct Frame {
+    size_t node;
+    Clock::time_point start;
+};
+
+std::vector<FunctionTotals> functions;
+std::unordered_map<std::string, size_t> functionIndex;
+std::vector<ContextNode> nodes(1, ContextNode{0, 0, {}});
+std::vector<Frame> frames;
+size_t currentNode = 0;
+
+size_t findFunction(const std::string& name) {
+    auto it = functionIndex.find(name);
+    if (it != functionIndex.end()) return it->second;
+    functions.push_back(FunctionTotals{name});
+    functionIndex.emplace(name, functions.size() - 1);
+    return functions.size() - 1;
+}
+
+size_t findChild(size_t parent, size_t function) {
+    for (size_t child : nodes[parent].children) {
+        if (nodes[child].function == function) return child;
+    }
+    nodes.push_back(ContextNode{function, parent, {}});
+    nodes[parent].children.push_back(nodes.size() - 1);
+    return nodes.size() - 1;
+}
+
+double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+void writeStacks(std::ostream& out, size_t node, std::string& path) {
+    size_t length = path.size();
+    if (node != 0) {
+        if (length > 0) path += ';';
+        path += functions[nodes[node].function].name;
+        auto self = std::chrono::duration_cast<std::chrono::microseconds>(
+            nodes[node].inclusive - nodes[node].childTime).count();
+        if (self > 0) out << path << ' ' << self << '\n';
+    }
+    for (size_t child : nodes[node].children) {
+        writeStacks(out, child, path);
+    }
+    path.resize(length);
+}
+
+}
+
+void FunctionProfiler::enable() {
+    active = true;
+}
+
+FunctionProfiler::Call::Call(const std::string& name) : timing(active) {
+    if (timing) enter(name);
+}
+
+FunctionProfiler::Call::~Call() {
+    if (timing) leave();
+}
+
+void FunctionProfiler::enter(const std::string& name) {
+    size_t function = findFunction(name);
+    functions[function].activeCalls++;
+    currentNode = findChild(currentNode, function);
+    frames.push_back(Frame{currentNode, Clock::now()});
+}
+
+void FunctionProfiler::leave() {
+    Clock::duration elapsed = Clock::now() - frames.back().start;
+    frames.pop_back();
+
+    ContextNode& node = nodes[currentNode];
+    node.calls++;
+    node.inclusive += elapsed;
+    nodes[node.parent].childTime += elapsed;
+
+    FunctionTotals& function = functions[node.function];
+    function.calls++;
+    if (--function.activeCalls == 0) function.inclusive += elapsed;
+    currentNode = node.parent;
+}
+
+void FunctionProfiler::reportTable(std::ostream& out) {
+    std::vector<Clock::duration> exclusive(functions.size());
+    for (size_t i = 1; i < nodes.size(); i++) {
+        exclusive[nodes[i].function] += nodes[i].inclusive - nodes[i].childTime;
+    }
+    Clock::duration total = nodes[0].childTime;
+
+    std::vector<size_t> order(functions.size());
+    for (size_t i = 0; i < order.size(); i++) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return exclusive[a] > exclusive[b];
+    });
+
+    char line[256];
+    std::snprintf(line, sizeof line, "%-24s %12s %14s %14s %8s\n", "function", "calls", "inclusive ms",
+                  "exclusive ms", "excl %");
+    out << line;
+    for (size_t i : order) {
+        double share = total.count() > 0 ? 100.0 * exclusive[i].count() / total.count() : 0.0;
+        std::snprintf(line, sizeof line, "%-24s %12llu %14.3f %14.3f %8.1f\n", functions[i].name.c_str(),
+                      (unsigned long long)functions[i].calls, milliseconds(functions[i].inclusive),
+                      milliseconds(exclusive[i]), share);
+        out << line;
+    }
+}
+
+void FunctionProfiler::reportStacks(std::ostream& out) {
+    std::string path;
+    writeStacks(out, 0, path);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_FUNCTIONPROFILER_H
+#define PYTHON_INTERPRETER_FUNCTIONPROFILER_H
+
+#include <ostream>
+#include <string>
+
+// Opt-in call profiler for user functions and builtins. Every call is timed
+// in its calling context, so the report can give per-function inclusive and
+// exclusive time as well as collapsed stacks for flamegraph tools.
+class FunctionProfiler {
+public:
+    static bool enabled() {
+        return active;
+    }
+
+    static void enable();
+
+    // Times one call of name while alive; a no-op when profiling is off
+    class Call {
+    private:
+        bool timing;
+
+    public:
+        explicit Call(const std::string& name);
+        ~Call();
+
+        Call(const Call&) = delete;
+        Call& operator=(const Call&) = delete;
+    };
+
+    // The same timing for callers whose calls do not nest in a C++ scope,
+    // such as the virtual machine's; only call while profiling is enabled
+    static void enter(const std::string& name);
+    static void leave();
+
+    // Functions sorted by exclusive time, with call counts and inclusive time.
+    // Recursive calls add to a function's inclusive time only once.
+    static void reportTable(std::ostream& out);
+
+    // One "outer;inner <microseconds>" line per calling context, weighted by
+    // exclusive time, as read by flamegraph.pl and speedscope
+    static void reportStacks(std::ostream& out);
+
+private:
+    static bool active;
+};
+
+#endif//PYTHON_INTERPRETER_FUNCTIONPROFILER_H
@@ -0,0 +1,399 @@
+#include "Jit.h"
+#include <cstring>
+#include <unordered_map>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_SUPPORTED 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef JIT_SUPPORTED
+bool Jit::active = true;
+#else
+bool Jit::active = false;
+#endif
+
+namespace {
+
+// Entries and early exits beyond this many stop a loop from being tried
+constexpr uint32_t MAX_FAILURES = 16;
+
+#ifdef JIT_SUPPORTED
+
+// The registers the templates use: operands are loaded into RAX and RCX,
+// and the slots are addressed from RDI, the entry's argument. All are
+// caller-saved, so the code needs no prologue.
+enum Register : uint8_t { RAX = 0, RCX = 1 };
+
+// x86 condition codes, as in the low nibble of Jcc
+enum Condition : uint8_t {
+    OVERFLOW = 0x0,
+    EQUAL = 0x4,
+    NOT_EQUAL = 0x5,
+    LESS = 0xC,
+    GREATER_EQUAL = 0xD,
+    LESS_EQUAL = 0xE,
+    GREATER = 0xF
+};
+
+// Translates one loop; see Jit::compile
+class Translator {
+public:
+    Translator(const CodeObject& code, size_t start, size_t end) : code(code), start(start), end(end) {}
+
+    bool translate() {
+        labels.resize(end - start + 1);
+        for (size_t i = start; i <= end; i++) {
+            labels[i - start] = bytes.size();
+            if (!instruction(i, code.instructions[i])) {
+                return false;
+            }
+        }
+
+        // Each place the loop leaves by returns the instruction to resume at
+        std::unordered_map<uint32_t, size_t> exits;
+        for (const Fixup& fixup : fixups) {
+            size_t destination;
+            if (!fixup.leave && fixup.target >= start && fixup.target <= end) {
+                destination = labels[fixup.target - start];
+            } else {
+                auto found = exits.find(fixup.target);
+                if (found == exits.end()) {
+                    found = exits.emplace(fixup.target, bytes.size()).first;
+                    emit({0xB8});  // mov eax, imm32
+                    emit32(fixup.target);
+                    emit({0xC3});  // ret
+                }
+                destination = found->second;
+            }
+            int32_t offset = (int32_t)(destination - (fixup.at + 4));
+            std::memcpy(&bytes[fixup.at], &offset, 4);
+        }
+        return true;
+    }
+
+    std::vector<uint8_t> bytes;
+    std::vector<uint32_t> operands;
+    std::vector<bool> checked;
+    std::vector<bool> written;
+
+private:
+    struct Fixup {
+        size_t at;
+        uint32_t target;
+        // Leave at target even if it is in the loop
+        bool leave;
+    };
+
+    const CodeObject& code;
+    size_t start;
+    size_t end;
+    std::vector<size_t> labels;
+    std::vector<Fixup> fixups;
+    std::unordered_map<uint32_t, uint32_t> slots;
+
+    void emit(std::initializer_list<uint8_t> code) {
+        bytes.insert(bytes.end(), code);
+    }
+
+    void emit32(uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            bytes.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    void emit64(uint64_t value) {
+        for (int i = 0; i < 8; i++) {
+            bytes.push_back((uint8_t)(value >> (8 * i)));
+        }
+    }
+
+    void jump(uint32_t target, bool leave = false) {
+        emit({0xE9});
+        fixups.push_back({bytes.size(), target, leave});
+        emit32(0);
+    }
+
+    void jumpIf(Condition condition, uint32_t target, bool leave = false) {
+        emit({0x0F, (uint8_t)(0x80 | condition)});
+        fixups.push_back({bytes.size(), target, leave});
+        emit32(0);
+    }
+
+    // Byte offset of operand's slot from RDI. Temporaries are written
+    // before they are read in every statement, so only parameters, globals
+    // and registers the loop reads first (values hoisted out of it) must
+    // hold ints when the loop is entered.
+    uint32_t slot(uint32_t operand, bool write) {
+        auto found = slots.find(operand);
+        if (found == slots.end()) {
+            found = slots.emplace(operand, operands.size()).first;
+            operands.push_back(operand);
+            checked.push_back(!isRegister(operand) || operand < code.parameterCount || !write);
+            written.push_back(false);
+        }
+        if (write) {
+            written[found->second] = true;
+        }
+        return found->second * 8;
+    }
+
+    bool load(Register target, uint32_t operand) {
+        if (operand >= CONSTANT_OPERAND) {
+            const Value& value = code.constants[operand - CONSTANT_OPERAND];
+            int64_t number;
+            if (value.type != ValueType::INT || !value.intVal.toInt64(number)) {
+                return false;
+            }
+            if (number == (int32_t)number) {
+                emit({0x48, 0xC7, (uint8_t)(0xC0 | target)});  // mov r64, imm32
+                emit32((uint32_t)number);
+            } else {
+                emit({0x48, (uint8_t)(0xB8 | target)});  // mov r64, imm64
+                emit64((uint64_t)number);
+            }
+            return true;
+        }
+        emit({0x48, 0x8B, (uint8_t)(0x87 | (target << 3))});  // mov r64, [rdi + disp32]
+        emit32(slot(operand, false));
+        return true;
+    }
+
+    bool store(uint32_t operand) {
+        if (operand >= CONSTANT_OPERAND) {
+            return false;
+        }
+        emit({0x48, 0x89, 0x87});  // mov [rdi + disp32], rax
+        emit32(slot(operand, true));
+        return true;
+    }
+
+    bool instruction(size_t index, const Instruction& instruction) {
+        switch (instruction.op) {
+            case Opcode::MOVE:
+                return load(RAX, instruction.b) && store(instruction.a);
+
+            case Opcode::NEGATE:
+                if (!load(RAX, instruction.b)) return false;
+                emit({0x48, 0xF7, 0xD8});  // neg rax
+                jumpIf(OVERFLOW, index, true);
+                return store(instruction.a);
+
+            case Opcode::JUMP:
+            case Opcode::LOOP:
+            case Opcode::LOOP_NATIVE:
+                jump(instruction.a);
+                return true;
+
+            case Opcode::JUMP_IF_FALSE:
+            case Opcode::JUMP_IF_TRUE:
+                if (!load(RAX, instruction.b)) return false;
+                emit({0x48, 0x85, 0xC0});  // test rax, rax
+                jumpIf(instruction.op == Opcode::JUMP_IF_FALSE ? EQUAL : NOT_EQUAL, instruction.a);
+                return true;
+
+            case Opcode::ADD:
+            case Opcode::ADD_INT:
+            case Opcode::ADD_I64:
+            case Opcode::SUB:
+            case Opcode::SUB_INT:
+            case Opcode::SUB_I64:
+            case Opcode::MUL:
+            case Opcode::MUL_INT:
+            case Opcode::MUL_I64:
+            case Opcode::FLOORDIV:
+            case Opcode::FLOORDIV_INT:
+            case Opcode::FLOORDIV_I64:
+            case Opcode::MOD:
+            case Opcode::MOD_INT:
+            case Opcode::MOD_I64:
+                return binary(index, instruction);
+
+            case Opcode::LT:
+            case Opcode::LT_INT:
+            case Opcode::LT_I64:
+            case Opcode::GT:
+            case Opcode::GT_INT:
+            case Opcode::GT_I64:
+            case Opcode::LE:
+            case Opcode::LE_INT:
+            case Opcode::LE_I64:
+            case Opcode::GE:
+            case Opcode::GE_INT:
+            case Opcode::GE_I64:
+            case Opcode::EQ:
+            case Opcode::EQ_INT:
+            case Opcode::EQ_I64:
+            case Opcode::NE:
+            case Opcode::NE_INT:
+            case Opcode::NE_I64:
+                return compare(instruction);
+
+            default:
+                return false;
+        }
+    }
+
+    bool binary(size_t index, const Instruction& instruction) {
+        if (!load(RAX, instruction.b) || !load(RCX, instruction.c)) {
+            return false;
+        }
+        switch ((BinaryOp)instruction.sub) {
+            case BinaryOp::ADD:
+                emit({0x48, 0x01, 0xC8});  // add rax, rcx
+                break;
+            case BinaryOp::SUB:
+                emit({0x48, 0x29, 0xC8});  // sub rax, rcx
+                break;
+            case BinaryOp::MUL:
+                emit({0x48, 0x0F, 0xAF, 0xC1});  // imul rax, rcx
+                break;
+            case BinaryOp::FLOORDIV:
+            case BinaryOp::MOD:
+                // Division by zero raises and by -1 may overflow; both are
+                // left to the interpreter
+                emit({0x48, 0x85, 0xC9});  // test rcx, rcx
+                jumpIf(EQUAL, index, true);
+                emit({0x48, 0x83, 0xF9, 0xFF});  // cmp rcx, -1
+                jumpIf(EQUAL, index, true);
+                emit({0x48, 0x99});        // cqo
+                emit({0x48, 0xF7, 0xF9});  // idiv rcx
+                // idiv truncates; a nonzero remainder whose sign differs
+                // from the divisor's moves the quotient down, as in Python
+                emit({0x48, 0x85, 0xD2});  // test rdx, rdx
+                emit({0x74, 0x0E});        // jz done
+                emit({0x49, 0x89, 0xD0});  // mov r8, rdx
+                emit({0x49, 0x31, 0xC8});  // xor r8, rcx
+                emit({0x79, 0x06});        // jns done
+                emit({0x48, 0xFF, 0xC8});  // dec rax
+                emit({0x48, 0x01, 0xCA});  // add rdx, rcx
+                if ((BinaryOp)instruction.sub == BinaryOp::MOD) {
+                    emit({0x48, 0x89, 0xD0});  // mov rax, rdx
+                }
+                return store(instruction.a);
+            default:
+                return false;
+        }
+        jumpIf(OVERFLOW, index, true);
+        return store(instruction.a);
+    }
+
+    bool compare(const Instruction& instruction) {
+        // Only compare-and-branch: a stored bool is not an int slot
+        if (!(instruction.sub & BRANCH_IF_FALSE)) {
+            return false;
+        }
+        if (!load(RAX, instruction.b) || !load(RCX, instruction.c)) {
+            return false;
+        }
+        emit({0x48, 0x39, 0xC8});  // cmp rax, rcx
+        Condition whenFalse;
+        switch ((CompareOp)(instruction.sub & ~BRANCH_IF_FALSE)) {
+            case CompareOp::LT:
+                whenFalse = GREATER_EQUAL;
+                break;
+            case CompareOp::GT:
+                whenFalse = LESS_EQUAL;
+                break;
+            case CompareOp::LE:
+                whenFalse = GREATER;
+                break;
+            case CompareOp::GE:
+                whenFalse = LESS;
+                break;
+            case CompareOp::EQ:
+                whenFalse = NOT_EQUAL;
+                break;
+            default:
+                whenFalse = EQUAL;
+                break;
+        }
+        jumpIf(whenFalse, instruction.a);
+        return true;
+    }
+};
+
+#endif
+
+}
+
+void Jit::disable() {
+    active = false;
+}
+
+Jit::~Jit() {
+#ifdef JIT_SUPPORTED
+    for (Loop& loop : loops) {
+        munmap(loop.memory, loop.size);
+    }
+#endif
+}
+
+uint32_t Jit::compile(const CodeObject& code, size_t start, size_t end) {
+#ifdef JIT_SUPPORTED
+    Translator translator(code, start, end);
+    if (!translator.translate()) {
+        return NONE;
+    }
+
+    // Written while writable, then made executable instead
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t size = (translator.bytes.size() + page - 1) / page * page;
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return NONE;
+    }
+    std::memcpy(memory, translator.bytes.data(), translator.bytes.size());
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return NONE;
+    }
+
+    Loop loop;
+    loop.entry = reinterpret_cast<Entry>(memory);
+    loop.memory = memory;
+    loop.size = size;
+    loop.start = start;
+    loop.end = end;
+    loop.operands = std::move(translator.operands);
+    loop.checked = std::move(translator.checked);
+    loop.written = std::move(translator.written);
+    loop.slots.assign(loop.operands.size(), 0);
+    loops.push_back(std::move(loop));
+    return loops.size() - 1;
+#else
+    return NONE;
+#endif
+}
+
+bool Jit::run(uint32_t index, Value* registers, Value* globals, uint32_t& resume) {
+    Loop& loop = loops[index];
+    for (size_t i = 0; i < loop.operands.size(); i++) {
+        uint32_t operand = loop.operands[i];
+        const Value& value = isRegister(operand) ? registers[operand] : globals[operand - GLOBAL_OPERAND];
+        if (loop.checked[i] && (value.type != ValueType::INT || !value.intVal.toInt64(loop.slots[i]))) {
+            loop.failures++;
+            return false;
+        }
+    }
+
+    resume = loop.entry(loop.slots.data());
+
+    for (size_t i = 0; i < loop.operands.size(); i++) {
+        if (loop.written[i]) {
+            uint32_t operand = loop.operands[i];
+            Value& value = isRegister(operand) ? registers[operand] : globals[operand - GLOBAL_OPERAND];
+            value.type = ValueType::INT;
+            value.intVal.assign(loop.slots[i]);
+        }
+    }
+    if (resume >= loop.start && resume <= loop.end) {
+        loop.failures++;
+    }
+    return true;
+}
+
+bool Jit::exhausted(uint32_t index) const {
+    return loops[index].failures >= MAX_FAILURES;
+}
@@ -0,0 +1,74 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_JIT_H
+#define PYTHON_INTERPRETER_JIT_H
+
+#include "Bytecode.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Baseline JIT for hot while loops on x86-64. A loop whose instructions are
+// all int arithmetic, branching comparisons and jumps over registers,
+// globals and int constants is translated one template per instruction
+// into machine code that keeps each operand unboxed in an int64 slot.
+// Operands are checked and unboxed when the loop is entered and boxed again
+// when it leaves. An overflow, or a division the templates leave alone,
+// leaves at that instruction instead, and the interpreter runs it with
+// arbitrary precision. On by default where supported; --no-jit turns it off.
+class Jit {
+public:
+    // Back-edges a loop takes before it is compiled
+    static constexpr uint32_t HOT_LOOP = 64;
+    static constexpr uint32_t NONE = UINT32_MAX;
+
+    static bool enabled() {
+        return active;
+    }
+
+    static void disable();
+
+    Jit() = default;
+    ~Jit();
+
+    Jit(const Jit&) = delete;
+    Jit& operator=(const Jit&) = delete;
+
+    // Translates the loop whose code runs from start to its back-edge at
+    // end, returning its index for run, or NONE when an instruction there
+    // has no template
+    uint32_t compile(const CodeObject& code, size_t start, size_t end);
+
+    // Runs compiled loop from its start on the running call's registers and
+    // sets resume to the instruction the interpreter continues at; false,
+    // with nothing run and resume untouched, when an operand does not hold
+    // a small int
+    bool run(uint32_t loop, Value* registers, Value* globals, uint32_t& resume);
+
+    // Whether the loop keeps failing to enter or leaving early, so the
+    // interpreter should stop trying it
+    bool exhausted(uint32_t loop) const;
+
+private:
+    using Entry = uint32_t (*)(int64_t* slots);
+
+    struct Loop {
+        Entry entry;
+        void* memory;
+        size_t size;
+        size_t start;
+        size_t end;
+        // Slot i holds operands[i]; checked slots are unboxed on entry and
+        // written ones boxed on the way out
+        std::vector<uint32_t> operands;
+        std::vector<bool> checked;
+        std::vector<bool> written;
+        std::vector<int64_t> slots;
+        uint32_t failures = 0;
+    };
+
+    std::vector<Loop> loops;
+
+    static bool active;
+};
+
+#endif//PYTHON_INTERPRETER_JIT_H
@@ -0,0 +1,142 @@
+#include "LimbKernels.h"
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define LIMB_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace limb {
+
+namespace {
+
+const Kernels SCALAR_KERNELS = {"scalar", addScalar, subScalar, compareScalar};
+
+#ifdef LIMB_KERNELS_AVX2
+
+// Carry lookahead for eight lanes at once. A lane generates a carry when its
+// sum reaches BASE and propagates one when it is exactly BASE - 1. Adding the
+// generate bits (shifted to the lane they feed) onto the propagate bits lets
+// ordinary integer addition ripple carries through runs of BASE - 1 lanes;
+// the bits that flipped are the lanes that receive a carry, and bit 8 is the
+// carry out of the block. Borrows in subtraction work the same way with
+// "negative" and "zero" in place of "overflowed" and "BASE - 1".
+
+__attribute__((target("avx2")))
+inline __m256i expandLaneMask(uint32_t bits) {
+    const __m256i laneBits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    __m256i broadcast = _mm256_set1_epi32((int)bits);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(broadcast, laneBits), laneBits);
+}
+
+__attribute__((target("avx2")))
+inline uint32_t laneMask(__m256i lanes) {
+    return (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(lanes));
+}
+
+__attribute__((target("avx2")))
+uint32_t addAvx2(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n) {
+    const __m256i base = _mm256_set1_epi32((int)BASE);
+    const __m256i baseMinusOne = _mm256_set1_epi32((int)BASE - 1);
+
+    uint32_t carry = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i sum = _mm256_add_epi32(va, vb);  // < 2 * BASE, no signed overflow
+
+        uint32_t generate = laneMask(_mm256_cmpgt_epi32(sum, baseMinusOne));
+        uint32_t propagate = laneMask(_mm256_cmpeq_epi32(sum, baseMinusOne));
+        uint32_t rippled = propagate + ((generate << 1) | carry);
+        uint32_t carries = (rippled ^ propagate) & 0xff;
+        carry = rippled >> 8;
+
+        sum = _mm256_sub_epi32(sum, expandLaneMask(carries));
+        __m256i overflow = _mm256_cmpgt_epi32(sum, baseMinusOne);
+        sum = _mm256_sub_epi32(sum, _mm256_and_si256(overflow, base));
+        _mm256_storeu_si256((__m256i*)(result + i), sum);
+    }
+
+    for (; i < n; i++) {
+        uint32_t sum = a[i] + b[i] + carry;
+        carry = sum >= BASE;
+        result[i] = carry ? sum - BASE : sum;
+    }
+    return carry;
+}
+
+__attribute__((target("avx2")))
+uint32_t subAvx2(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n) {
+    const __m256i base = _mm256_set1_epi32((int)BASE);
+    const __m256i zero = _mm256_setzero_si256();
+
+    uint32_t borrow = 0;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        __m256i diff = _mm256_sub_epi32(va, vb);  // in (-BASE, BASE)
+
+        uint32_t generate = laneMask(_mm256_cmpgt_epi32(zero, diff));
+        uint32_t propagate = laneMask(_mm256_cmpeq_epi32(diff, zero));
+        uint32_t rippled = propagate + ((generate << 1) | borrow);
+        uint32_t borrows = (rippled ^ propagate) & 0xff;
+        borrow = rippled >> 8;
+
+        diff = _mm256_add_epi32(diff, expandLaneMask(borrows));
+        __m256i underflow = _mm256_cmpgt_epi32(zero, diff);
+        diff = _mm256_add_epi32(diff, _mm256_and_si256(underflow, base));
+        _mm256_storeu_si256((__m256i*)(result + i), diff);
+    }
+
+    for (; i < n; i++) {
+        int32_t diff = (int32_t)a[i] - (int32_t)b[i] - (int32_t)borrow;
+        borrow = diff < 0;
+        result[i] = borrow ? (uint32_t)(diff + (int32_t)BASE) : (uint32_t)diff;
+    }
+    return borrow;
+}
+
+__attribute__((target("avx2")))
+int compareAvx2(const uint32_t* a, const uint32_t* b, size_t n) {
+    // Scan eight limbs at a time from the top for the first difference
+    size_t i = n;
+    while (i >= 8) {
+        i -= 8;
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        uint32_t equal = laneMask(_mm256_cmpeq_epi32(va, vb));
+        if (equal != 0xff) {
+            size_t lane = 31 - __builtin_clz(~equal & 0xff);
+            return a[i + lane] < b[i + lane] ? -1 : 1;
+        }
+    }
+    return compareScalar(a, b, i);
+}
+
+const Kernels AVX2_KERNELS = {"avx2", addAvx2, subAvx2, compareAvx2};
+
+#endif
+
+}  // namespace
+
+const Kernels& scalarKernels() {
+    return SCALAR_KERNELS;
+}
+
+const Kernels* avx2Kernels() {
+#ifdef LIMB_KERNELS_AVX2
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &AVX2_KERNELS;
+    }
+#endif
+    return nullptr;
+}
+
+const Kernels& activeKernels() {
+    static const Kernels& selected = avx2Kernels() ? *avx2Kernels() : scalarKernels();
+    return selected;
+}
+
+}  // namespace limb
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_LIMBKERNELS_H
+#define PYTHON_INTERPRETER_LIMBKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Carry-propagating kernels over base 10^9 limbs (least significant first).
+// Vectorized versions are picked once at startup from the CPU's features;
+// short operands skip the dispatch and run the inline scalar loops.
+namespace limb {
+
+constexpr uint32_t BASE = 1000000000;
+constexpr size_t VECTOR_THRESHOLD = 16;
+
+// result[i] = a[i] + b[i] + carry for i < n; returns the carry out.
+// result may alias a or b.
+inline uint32_t addScalar(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n) {
+    uint32_t carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t sum = a[i] + b[i] + carry;
+        carry = sum >= BASE;
+        result[i] = carry ? sum - BASE : sum;
+    }
+    return carry;
+}
+
+// result[i] = a[i] - b[i] - borrow for i < n; returns the borrow out.
+// result may alias a or b.
+inline uint32_t subScalar(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n) {
+    uint32_t borrow = 0;
+    for (size_t i = 0; i < n; i++) {
+        int32_t diff = (int32_t)a[i] - (int32_t)b[i] - (int32_t)borrow;
+        borrow = diff < 0;
+        result[i] = borrow ? (uint32_t)(diff + (int32_t)BASE) : (uint32_t)diff;
+    }
+    return borrow;
+}
+
+// Three-way comparison of two n-limb magnitudes: -1, 0 or 1
+inline int compareScalar(const uint32_t* a, const uint32_t* b, size_t n) {
+    for (size_t i = n; i-- > 0;) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+struct Kernels {
+    const char* name;
+    uint32_t (*add)(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n);
+    uint32_t (*sub)(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n);
+    int (*compare)(const uint32_t* a, const uint32_t* b, size_t n);
+};
+
+const Kernels& scalarKernels();
+// nullptr when the compiler or the CPU lacks AVX2
+const Kernels* avx2Kernels();
+const Kernels& activeKernels();
+
+inline uint32_t add(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n) {
+    if (n < VECTOR_THRESHOLD) return addScalar(result, a, b, n);
+    return activeKernels().add(result, a, b, n);
+}
+
+inline uint32_t sub(uint32_t* result, const uint32_t* a, const uint32_t* b, size_t n) {
+    if (n < VECTOR_THRESHOLD) return subScalar(result, a, b, n);
+    return activeKernels().sub(result, a, b, n);
+}
+
+inline int compare(const uint32_t* a, const uint32_t* b, size_t n) {
+    if (n < VECTOR_THRESHOLD) return compareScalar(a, b, n);
+    return activeKernels().compare(a, b, n);
+}
+
+}  // namespace limb
+
+#endif//PYTHON_INTERPRETER_LIMBKERNELS_H
@@ -0,0 +1,105 @@
+#include "LineProfiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+bool LineProfiler::active = false;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct LineTotals {
+    uint64_t hits = 0;
+    uint64_t iterations = 0;
+    Clock::duration total{};
+    Clock::duration self{};
+    int activeHits = 0;
+    std::string text;
+};
+
+struct Frame {
+    size_t line;
+    Clock::time_point start;
+    Clock::duration childTime;
+};
+
+std::vector<LineTotals> lines;
+std::vector<Frame> frames;
+
+LineTotals& lineOf(antlr4::Token* start) {
+    size_t line = start->getLine();
+    if (line >= lines.size()) lines.resize(line + 1);
+    LineTotals& totals = lines[line];
+    if (totals.text.empty()) {
+        // The source line the statement starts on, for the report
+        antlr4::CharStream* input = start->getInputStream();
+        size_t begin = start->getStartIndex() - start->getCharPositionInLine();
+        size_t end = std::min(begin + 60, input->size()) - 1;
+        totals.text = input->getText(antlr4::misc::Interval(begin, end));
+        totals.text.resize(std::min(totals.text.find('\n'), totals.text.size()));
+    }
+    return totals;
+}
+
+double milliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+}
+
+void LineProfiler::enable() {
+    active = true;
+}
+
+LineProfiler::Hit::Hit(antlr4::Token* start) : timing(active) {
+    if (timing) enter(start);
+}
+
+LineProfiler::Hit::~Hit() {
+    if (timing) leave();
+}
+
+void LineProfiler::enter(antlr4::Token* start) {
+    lineOf(start).activeHits++;
+    frames.push_back(Frame{start->getLine(), Clock::now(), Clock::duration{}});
+}
+
+void LineProfiler::leave() {
+    Frame frame = frames.back();
+    frames.pop_back();
+    Clock::duration elapsed = Clock::now() - frame.start;
+
+    LineTotals& totals = lines[frame.line];
+    totals.hits++;
+    totals.self += elapsed - frame.childTime;
+    // A line that is still running further up (recursion) already counts
+    // this time in its own total
+    if (--totals.activeHits == 0) totals.total += elapsed;
+    if (!frames.empty()) frames.back().childTime += elapsed;
+}
+
+void LineProfiler::countIteration(antlr4::Token* start) {
+    if (active) lineOf(start).iterations++;
+}
+
+void LineProfiler::report(std::ostream& out) {
+    Clock::duration all{};
+    for (const LineTotals& totals : lines) all += totals.self;
+
+    char line[256];
+    std::snprintf(line, sizeof line, "%6s %12s %12s %12s %12s %7s  %s\n", "line", "hits", "iterations",
+                  "total ms", "self ms", "self %", "source");
+    out << line;
+    for (size_t i = 0; i < lines.size(); i++) {
+        const LineTotals& totals = lines[i];
+        if (totals.hits == 0) continue;
+        double share = all.count() > 0 ? 100.0 * totals.self.count() / all.count() : 0.0;
+        std::snprintf(line, sizeof line, "%6zu %12llu %12llu %12.3f %12.3f %7.1f  %s\n", i,
+                      (unsigned long long)totals.hits, (unsigned long long)totals.iterations,
+                      milliseconds(totals.total), milliseconds(totals.self), share, totals.text.c_str());
+        out << line;
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_LINEPROFILER_H
+#define PYTHON_INTERPRETER_LINEPROFILER_H
+
+#include "antlr4-runtime.h"
+#include <ostream>
+
+// Opt-in statement profiler keyed by source line: how often each statement
+// ran, how many iterations each while loop made, and the time spent in it
+// with and without the statements (and calls) nested inside.
+class LineProfiler {
+public:
+    static bool enabled() {
+        return active;
+    }
+
+    static void enable();
+
+    // Times one execution of the statement starting at start while alive;
+    // a no-op when profiling is off
+    class Hit {
+    private:
+        bool timing;
+
+    public:
+        explicit Hit(antlr4::Token* start);
+        ~Hit();
+
+        Hit(const Hit&) = delete;
+        Hit& operator=(const Hit&) = delete;
+    };
+
+    // The same timing for statements that do not nest in a C++ scope, such
+    // as the virtual machine's; only call while profiling is enabled
+    static void enter(antlr4::Token* start);
+    static void leave();
+
+    // One pass through the body of the loop starting at start
+    static void countIteration(antlr4::Token* start);
+
+    // Every line that ran, in source order, with its text
+    static void report(std::ostream& out);
+
+private:
+    static bool active;
+};
+
+#endif//PYTHON_INTERPRETER_LINEPROFILER_H
@@ -0,0 +1,130 @@
+#include "MemoCache.h"
+#include <cstring>
+#include <functional>
+
+size_t MemoCache::capacity = 0;
+
+namespace {
+
+size_t combine(size_t seed, size_t value) {
+    return seed ^ (value + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+}
+
+// Floats are hashed and compared by their bits, which keeps 0.0 and -0.0
+// apart (they print differently) and lets a NaN argument hit
+uint64_t floatBits(double value) {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof bits);
+    return bits;
+}
+
+size_t hashValue(const Value& value) {
+    size_t seed = (size_t)value.type;
+    switch (value.type) {
+        case ValueType::BOOL:
+            return combine(seed, value.boolVal);
+        case ValueType::INT:
+            return combine(seed, value.intVal.hash());
+        case ValueType::FLOAT:
+            return combine(seed, std::hash<uint64_t>()(floatBits(value.floatVal)));
+        case ValueType::STRING:
+            return combine(seed, std::hash<std::string>()(value.strVal));
+        case ValueType::TUPLE:
+            for (const Value& item : value.tupleItems()) {
+                seed = combine(seed, hashValue(item));
+            }
+            return seed;
+        default:
+            return seed;
+    }
+}
+
+bool sameValue(const Value& a, const Value& b) {
+    if (a.type != b.type) {
+        return false;
+    }
+    switch (a.type) {
+        case ValueType::BOOL:
+            return a.boolVal == b.boolVal;
+        case ValueType::INT:
+            return a.intVal == b.intVal;
+        case ValueType::FLOAT:
+            return floatBits(a.floatVal) == floatBits(b.floatVal);
+        case ValueType::STRING:
+            return a.strVal == b.strVal;
+        case ValueType::TUPLE: {
+            const std::vector<Value>& left = a.tupleItems();
+            const std::vector<Value>& right = b.tupleItems();
+            if (left.size() != right.size()) {
+                return false;
+            }
+            for (size_t i = 0; i < left.size(); i++) {
+                if (!sameValue(left[i], right[i])) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        default:
+            return true;
+    }
+}
+
+}
+
+void MemoCache::enable(size_t entries) {
+    capacity = entries;
+}
+
+size_t MemoCache::hash(const Value* arguments, size_t count) {
+    size_t seed = count;
+    for (size_t i = 0; i < count; i++) {
+        seed = combine(seed, hashValue(arguments[i]));
+    }
+    return seed;
+}
+
+const Value* MemoCache::find(const Value* arguments, size_t count, size_t hash) {
+    auto range = index.equal_range(hash);
+    for (auto found = range.first; found != range.second; ++found) {
+        Entry& entry = *found->second;
+        if (entry.arguments.size() != count) {
+            continue;
+        }
+        bool same = true;
+        for (size_t i = 0; i < count && same; i++) {
+            same = sameValue(entry.arguments[i], arguments[i]);
+        }
+        if (same) {
+            entries.splice(entries.begin(), entries, found->second);
+            return &entry.result;
+        }
+    }
+    return nullptr;
+}
+
+void MemoCache::insert(std::vector<Value> arguments, size_t hash, const Value& result) {
+    // A recursive def may have cached these arguments from a nested call
+    // in the meantime
+    if (find(arguments.data(), arguments.size(), hash)) {
+        return;
+    }
+    if (entries.size() >= capacity) {
+        const Entry& oldest = entries.back();
+        auto range = index.equal_range(oldest.hash);
+        for (auto found = range.first; found != range.second; ++found) {
+            if (found->second == std::prev(entries.end())) {
+                index.erase(found);
+                break;
+            }
+        }
+        entries.pop_back();
+    }
+    entries.push_front(Entry{std::move(arguments), hash, result});
+    index.emplace(hash, entries.begin());
+}
+
+void MemoCache::clear() {
+    entries.clear();
+    index.clear();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_MEMOCACHE_H
+#define PYTHON_INTERPRETER_MEMOCACHE_H
+
+#include "Value.h"
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// Opt-in (--memoize) result cache of a pure def: the results of its most
+// recent calls, by argument tuple, up to a bounded number of entries per def
+// with the least recently used one evicted first. Arguments match only when
+// they have the same type and the same value, so f(1) and f(1.0) are cached
+// apart.
+class MemoCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 65536;
+
+    static bool enabled() {
+        return capacity != 0;
+    }
+
+    static void enable(size_t entries = DEFAULT_CAPACITY);
+
+    static size_t hash(const Value* arguments, size_t count);
+
+    // The result cached for the arguments, now the most recently used, or
+    // null
+    const Value* find(const Value* arguments, size_t count, size_t hash);
+
+    void insert(std::vector<Value> arguments, size_t hash, const Value& result);
+
+    void clear();
+
+private:
+    struct Entry {
+        std::vector<Value> arguments;
+        size_t hash;
+        Value result;
+    };
+
+    // Most recently used first; index finds the entries by hash
+    std::list<Entry> entries;
+    std::unordered_multimap<size_t, std::list<Entry>::iterator> index;
+
+    static size_t capacity;
+};
+
+#endif//PYTHON_INTERPRETER_MEMOCACHE_H
@@ -0,0 +1,19 @@
+#include "PoolAllocator.h"
+#include <algorithm>
+
+thread_local SizeClassPool::Block* SizeClassPool::freeLists[RuntimeStats::CATEGORY_COUNT][CLASS_COUNT];
+
+void* SizeClassPool::refill(size_t index, RuntimeStats::Category category) {
+    // At least 16 KiB and 8 blocks per chunk, so refills stay rare
+    size_t size = classSize(index);
+    size_t count = std::max<size_t>(8, 16384 / size);
+    char* chunk = static_cast<char*>(RuntimeStats::allocate(size * count, category, true));
+
+    Block*& head = freeLists[category][index];
+    for (size_t i = count - 1; i >= 1; i--) {
+        Block* block = reinterpret_cast<Block*>(chunk + i * size);
+        block->next = head;
+        head = block;
+    }
+    return chunk;
+}
@@ -0,0 +1,101 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_POOLALLOCATOR_H
+#define PYTHON_INTERPRETER_POOLALLOCATOR_H
+
+#include "RuntimeStats.h"
+#include <cstddef>
+
+// Size-class free lists for the interpreter's short-lived blocks: limb
+// buffers and heap Values. Blocks up to MAX_SIZE are carved
+// from chunks that are never returned to malloc, and a freed block goes back
+// on its class's list for the next allocation of that size. Lists are per
+// thread, so the multiplication pool's workers need no locking; a block freed
+// on another thread simply joins that thread's list.
+class SizeClassPool {
+public:
+    static constexpr size_t MAX_SIZE = 4096;
+
+    static void* allocate(size_t size, RuntimeStats::Category category) {
+        if (size > MAX_SIZE) return RuntimeStats::allocate(size, category);
+        if (RuntimeStats::enabled()) RuntimeStats::countPooled(size, category);
+        Block*& head = freeLists[category][classOf(size)];
+        if (!head) return refill(classOf(size), category);
+        Block* block = head;
+        head = block->next;
+        return block;
+    }
+
+    // size must be the size the block was allocated with
+    static void deallocate(void* pointer, size_t size, RuntimeStats::Category category) noexcept {
+        if (size > MAX_SIZE) {
+            RuntimeStats::deallocate(pointer, category);
+            return;
+        }
+        Block* block = static_cast<Block*>(pointer);
+        Block*& head = freeLists[category][classOf(size)];
+        block->next = head;
+        head = block;
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    // 16-byte steps up to 256 bytes, then powers of two up to MAX_SIZE
+    static constexpr size_t SMALL_CLASSES = 16;
+    static constexpr size_t CLASS_COUNT = SMALL_CLASSES + 4;
+
+    static size_t classOf(size_t size) {
+        if (size <= 256) return size ? (size - 1) / 16 : 0;
+        size_t index = SMALL_CLASSES;
+        for (size_t limit = 512; limit < size; limit <<= 1) index++;
+        return index;
+    }
+
+    static size_t classSize(size_t index) {
+        return index < SMALL_CLASSES ? (index + 1) * 16 : (size_t)256 << (index - SMALL_CLASSES + 1);
+    }
+
+    // Carve a fresh chunk into blocks of the class and return the first
+    static void* refill(size_t index, RuntimeStats::Category category);
+
+    static thread_local Block* freeLists[RuntimeStats::CATEGORY_COUNT][CLASS_COUNT];
+};
+
+// Standard allocator over SizeClassPool that files its chunks under a
+// RuntimeStats category
+template <class T, RuntimeStats::Category category>
+struct PoolAllocator {
+    using value_type = T;
+
+    template <class U>
+    struct rebind {
+        using other = PoolAllocator<U, category>;
+    };
+
+    PoolAllocator() = default;
+
+    template <class U>
+    PoolAllocator(const PoolAllocator<U, category>&) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(SizeClassPool::allocate(n * sizeof(T), category));
+    }
+
+    void deallocate(T* block, size_t n) noexcept {
+        SizeClassPool::deallocate(block, n * sizeof(T), category);
+    }
+
+    template <class U>
+    bool operator==(const PoolAllocator<U, category>&) const {
+        return true;
+    }
+
+    template <class U>
+    bool operator!=(const PoolAllocator<U, category>&) const {
+        return false;
+    }
+};
+
+#endif//PYTHON_INTERPRETER_POOLALLOCATOR_H
@@ -0,0 +1,190 @@
+#include "RuntimeStats.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+bool RuntimeStats::active = false;
+
+namespace {
+
+// Fed by RuntimeStats::allocate; relaxed is enough because the counters
+// are only read on the main thread after the work has joined
+std::atomic<bool> countAllocations(false);
+std::atomic<uint64_t> allocationCount(0);
+std::atomic<uint64_t> allocationBytes(0);
+
+// Live bytes are malloc's usable sizes, counted from enable(); blocks
+// allocated earlier and freed later can push a category slightly negative
+struct CategoryCounters {
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> mallocs{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<int64_t> live{0};
+    std::atomic<int64_t> peak{0};
+};
+
+CategoryCounters categories[RuntimeStats::CATEGORY_COUNT];
+std::atomic<int64_t> liveBytes(0);
+std::atomic<int64_t> peakLiveBytes(0);
+
+void raisePeak(std::atomic<int64_t>& peak, int64_t value) {
+    int64_t seen = peak.load(std::memory_order_relaxed);
+    while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {
+    }
+}
+
+using Clock = std::chrono::steady_clock;
+
+struct PhaseTotals {
+    double seconds = 0;
+    uint64_t allocations = 0;
+    uint64_t bytes = 0;
+};
+
+PhaseTotals totals[RuntimeStats::PHASE_COUNT];
+RuntimeStats::Phase current = RuntimeStats::EXECUTE;
+Clock::time_point lastSwitch;
+uint64_t lastCount = 0;
+uint64_t lastBytes = 0;
+
+// Charge everything since the previous switch to the current phase and make
+// next the current one
+void switchTo(RuntimeStats::Phase next) {
+    Clock::time_point now = Clock::now();
+    uint64_t count = allocationCount.load(std::memory_order_relaxed);
+    uint64_t bytes = allocationBytes.load(std::memory_order_relaxed);
+    PhaseTotals& phase = totals[current];
+    phase.seconds += std::chrono::duration<double>(now - lastSwitch).count();
+    phase.allocations += count - lastCount;
+    phase.bytes += bytes - lastBytes;
+    lastSwitch = now;
+    lastCount = count;
+    lastBytes = bytes;
+    current = next;
+}
+
+}
+
+void* RuntimeStats::allocate(size_t size, Category category, bool chunk) {
+    void* block = std::malloc(size == 0 ? 1 : size);
+    if (!block) throw std::bad_alloc();
+    if (countAllocations.load(std::memory_order_relaxed)) {
+        allocationCount.fetch_add(1, std::memory_order_relaxed);
+        allocationBytes.fetch_add(size, std::memory_order_relaxed);
+        CategoryCounters& counters = categories[category];
+        counters.mallocs.fetch_add(1, std::memory_order_relaxed);
+        if (!chunk) countPooled(size, category);
+        int64_t usable = malloc_usable_size(block);
+        raisePeak(counters.peak, counters.live.fetch_add(usable, std::memory_order_relaxed) + usable);
+        raisePeak(peakLiveBytes, liveBytes.fetch_add(usable, std::memory_order_relaxed) + usable);
+    }
+    return block;
+}
+
+void RuntimeStats::countPooled(size_t size, Category category) {
+    CategoryCounters& counters = categories[category];
+    counters.requests.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+void RuntimeStats::deallocate(void* block, Category category) noexcept {
+    if (block && countAllocations.load(std::memory_order_relaxed)) {
+        int64_t usable = malloc_usable_size(block);
+        categories[category].live.fetch_sub(usable, std::memory_order_relaxed);
+        liveBytes.fetch_sub(usable, std::memory_order_relaxed);
+    }
+    std::free(block);
+}
+
+void RuntimeStats::enable() {
+    active = true;
+    countAllocations.store(true, std::memory_order_relaxed);
+    lastSwitch = Clock::now();
+    lastCount = allocationCount.load(std::memory_order_relaxed);
+    lastBytes = allocationBytes.load(std::memory_order_relaxed);
+}
+
+void RuntimeStats::enter(Phase phase) {
+    if (active) switchTo(phase);
+}
+
+RuntimeStats::Scope::Scope(Phase phase) : previous(current), charging(active) {
+    if (charging) switchTo(phase);
+}
+
+RuntimeStats::Scope::~Scope() {
+    if (charging) switchTo(previous);
+}
+
+void RuntimeStats::report(std::ostream& out) {
+    if (!active) return;
+    switchTo(current);
+
+    static const char* const names[PHASE_COUNT] = {"lex", "parse", "execute", "output"};
+    PhaseTotals sum;
+    char line[128];
+    std::snprintf(line, sizeof line, "%-8s %12s %12s %14s\n", "phase", "time ms", "allocations", "bytes");
+    out << line;
+    for (int i = 0; i < PHASE_COUNT; i++) {
+        std::snprintf(line, sizeof line, "%-8s %12.3f %12llu %14llu\n", names[i], totals[i].seconds * 1e3,
+                      (unsigned long long)totals[i].allocations, (unsigned long long)totals[i].bytes);
+        out << line;
+        sum.seconds += totals[i].seconds;
+        sum.allocations += totals[i].allocations;
+        sum.bytes += totals[i].bytes;
+    }
+    std::snprintf(line, sizeof line, "%-8s %12.3f %12llu %14llu\n", "total", sum.seconds * 1e3,
+                  (unsigned long long)sum.allocations, (unsigned long long)sum.bytes);
+    out << line;
+
+    static const char* const categoryNames[CATEGORY_COUNT] = {"limbs", "values", "other"};
+    std::snprintf(line, sizeof line, "\n%-8s %12s %12s %14s %14s\n", "memory", "requests", "mallocs", "bytes",
+                  "peak live");
+    out << line;
+    uint64_t requests = 0;
+    uint64_t requestBytes = 0;
+    for (int i = 0; i < CATEGORY_COUNT; i++) {
+        const CategoryCounters& counters = categories[i];
+        requests += counters.requests.load(std::memory_order_relaxed);
+        requestBytes += counters.bytes.load(std::memory_order_relaxed);
+        std::snprintf(line, sizeof line, "%-8s %12llu %12llu %14llu %14lld\n", categoryNames[i],
+                      (unsigned long long)counters.requests.load(std::memory_order_relaxed),
+                      (unsigned long long)counters.mallocs.load(std::memory_order_relaxed),
+                      (unsigned long long)counters.bytes.load(std::memory_order_relaxed),
+                      (long long)counters.peak.load(std::memory_order_relaxed));
+        out << line;
+    }
+    std::snprintf(line, sizeof line, "%-8s %12llu %12llu %14llu %14lld\n", "total", (unsigned long long)requests,
+                  (unsigned long long)allocationCount.load(std::memory_order_relaxed),
+                  (unsigned long long)requestBytes, (long long)peakLiveBytes.load(std::memory_order_relaxed));
+    out << line;
+}
+
+// Every allocation without a category of its own goes through these, so the
+// tables also cover the ANTLR runtime and the standard containers
+void* operator new(size_t size) {
+    return RuntimeStats::allocate(size, RuntimeStats::OTHER);
+}
+
+void* operator new[](size_t size) {
+    return RuntimeStats::allocate(size, RuntimeStats::OTHER);
+}
+
+void operator delete(void* block) noexcept {
+    RuntimeStats::deallocate(block, RuntimeStats::OTHER);
+}
+
+void operator delete[](void* block) noexcept {
+    RuntimeStats::deallocate(block, RuntimeStats::OTHER);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    RuntimeStats::deallocate(block, RuntimeStats::OTHER);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    RuntimeStats::deallocate(block, RuntimeStats::OTHER);
+}
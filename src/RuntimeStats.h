@@ -0,0 +1,60 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_RUNTIMESTATS_H
+#define PYTHON_INTERPRETER_RUNTIMESTATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Opt-in accounting of where a run spends its time and allocations, split
+// into the interpreter's phases and, for memory, by what the blocks hold.
+// Enabled by --stats or PYTHON_INTERPRETER_STATS; when disabled every hook
+// is a single flag test.
+class RuntimeStats {
+public:
+    enum Phase { LEX, PARSE, EXECUTE, OUTPUT, PHASE_COUNT };
+
+    // BigInteger limbs, heap Values and tuple buffers, the rest
+    enum Category { LIMBS, VALUES, OTHER, CATEGORY_COUNT };
+
+    static bool enabled() {
+        return active;
+    }
+
+    // Start accounting; work done before this call is not reported
+    static void enable();
+
+    // Charge the work from here on to phase, for straight-line drivers
+    static void enter(Phase phase);
+
+    // Charges the work done while alive to a phase. Scopes nest: time spent
+    // in an inner scope is charged to the inner phase only.
+    class Scope {
+    private:
+        Phase previous;
+        bool charging;
+
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    // malloc and free with accounting; the global operator new uses OTHER.
+    // A chunk is malloc'd for SizeClassPool to carve up and is not itself a
+    // request; the pool reports the requests it serves through countPooled.
+    static void* allocate(size_t size, Category category, bool chunk = false);
+    static void deallocate(void* block, Category category) noexcept;
+    static void countPooled(size_t size, Category category);
+
+    // Per-phase table of wall time, malloc calls and bytes, then requests,
+    // malloc calls and peak live bytes per category
+    static void report(std::ostream& out);
+
+private:
+    static bool active;
+};
+
+#endif//PYTHON_INTERPRETER_RUNTIMESTATS_H
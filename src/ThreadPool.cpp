@@ -0,0 +1,66 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(size_t threads) {
+    for (size_t i = 1; i < threads; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    changed.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::workerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        changed.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;
+
+        auto task = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+void ThreadPool::invokeAll(std::vector<std::function<void()>>& tasks) {
+    if (tasks.empty()) return;
+
+    size_t pending = tasks.size() - 1;
+    std::condition_variable done;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t i = 1; i < tasks.size(); i++) {
+            queue.emplace_back([this, &tasks, &pending, &done, i] {
+                tasks[i]();
+                std::lock_guard<std::mutex> lock(mutex);
+                if (--pending == 0) done.notify_all();
+            });
+        }
+    }
+    changed.notify_all();
+
+    tasks[0]();
+
+    // Help with queued work (ours or a nested group's) until our tasks finish
+    std::unique_lock<std::mutex> lock(mutex);
+    while (pending > 0) {
+        if (!queue.empty()) {
+            auto task = std::move(queue.front());
+            queue.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        } else {
+            done.wait(lock);
+        }
+    }
+}
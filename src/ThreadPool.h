@@ -0,0 +1,43 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_THREADPOOL_H
+#define PYTHON_INTERPRETER_THREADPOOL_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for fork-join work. A thread waiting in
+// invokeAll runs queued tasks itself, so tasks may fork nested groups
+// without starving the pool.
+class ThreadPool {
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> queue;
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stopping = false;
+
+    void workerLoop();
+
+public:
+    // threads counts the calling thread, so threads - 1 workers are started
+    explicit ThreadPool(size_t threads);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t threadCount() const {
+        return workers.size() + 1;
+    }
+
+    // Run every task, the first one on the calling thread, and return once
+    // all of them have finished
+    void invokeAll(std::vector<std::function<void()>>& tasks);
+};
+
+#endif//PYTHON_INTERPRETER_THREADPOOL_H
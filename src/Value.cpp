@@ -0,0 +1,232 @@
+#include "Value.h"
+
+void floorDivMod(BigInteger& dividend, const BigInteger& divisor, BigInteger& remainder) {
+    // Divisors such as 2, 10 or 1000000007 take the single-word path
+    unsigned int word;
+    if (divisor.toWord(word) && word != 0) {
+        bool dividendNegative = dividend.isNegative();
+        long long rest = dividend.divmodWord(word);
+        if (dividendNegative) rest = -rest;
+        if (divisor.isNegative()) dividend.negate();
+
+        if (rest != 0 && (rest < 0) != divisor.isNegative()) {
+            dividend -= BigInteger(1);
+            rest += divisor.isNegative() ? -(long long)word : (long long)word;
+        }
+        remainder = BigInteger(rest);
+        return;
+    }
+
+    // Round the truncated quotient toward negative infinity
+    dividend.divmod_inplace(divisor, remainder);
+    if (!remainder.isZero() && remainder.isNegative() != divisor.isNegative()) {
+        dividend -= BigInteger(1);
+        remainder += divisor;
+    }
+}
+
+bool performInPlace(Value& target, const Value& right, BinaryOp op) {
+    if (target.type != ValueType::INT || right.type != ValueType::INT) {
+        return false;
+    }
+
+    switch (op) {
+        case BinaryOp::ADD:
+            target.intVal += right.intVal;
+            return true;
+        case BinaryOp::SUB:
+            target.intVal -= right.intVal;
+            return true;
+        case BinaryOp::MUL:
+            target.intVal *= right.intVal;
+            return true;
+        case BinaryOp::FLOORDIV: {
+            BigInteger remainder;
+            floorDivMod(target.intVal, right.intVal, remainder);
+            return true;
+        }
+        case BinaryOp::MOD: {
+            BigInteger remainder;
+            floorDivMod(target.intVal, right.intVal, remainder);
+            target.intVal = std::move(remainder);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+Value performBinary(BinaryOp op, const Value& a, const Value& b) {
+    switch (op) {
+        case BinaryOp::ADD:
+            return performAdd(a, b);
+        case BinaryOp::SUB:
+            return performSub(a, b);
+        case BinaryOp::MUL:
+            return performMul(a, b);
+        case BinaryOp::DIV:
+            return performDiv(a, b);
+        case BinaryOp::FLOORDIV:
+            return performFloorDiv(a, b);
+        case BinaryOp::MOD:
+            return performMod(a, b);
+    }
+    return Value::None();
+}
+
+Value performAdd(const Value& a, const Value& b) {
+    if (a.type == ValueType::INT && b.type == ValueType::INT) {
+        return Value::Int(a.intVal + b.intVal);
+    } else if (a.type == ValueType::FLOAT || b.type == ValueType::FLOAT) {
+        double aVal = (a.type == ValueType::FLOAT) ? a.floatVal : a.intVal.toDouble();
+        double bVal = (b.type == ValueType::FLOAT) ? b.floatVal : b.intVal.toDouble();
+        return Value::Float(aVal + bVal);
+    } else if (a.type == ValueType::STRING && b.type == ValueType::STRING) {
+        return Value::String(a.strVal + b.strVal);
+    } else if (a.type == ValueType::STRING && b.type == ValueType::INT) {
+        std::string result;
+        BigInteger count = b.intVal;
+        BigInteger zero(0);
+        while (count > zero) {
+            result += a.strVal;
+            count = count - BigInteger(1);
+        }
+        return Value::String(result);
+    }
+    return Value::None();
+}
+
+Value performSub(const Value& a, const Value& b) {
+    if (a.type == ValueType::INT && b.type == ValueType::INT) {
+        return Value::Int(a.intVal - b.intVal);
+    } else if (a.type == ValueType::FLOAT || b.type == ValueType::FLOAT) {
+        double aVal = (a.type == ValueType::FLOAT) ? a.floatVal : a.intVal.toDouble();
+        double bVal = (b.type == ValueType::FLOAT) ? b.floatVal : b.intVal.toDouble();
+        return Value::Float(aVal - bVal);
+    }
+    return Value::None();
+}
+
+Value performMul(const Value& a, const Value& b) {
+    if (a.type == ValueType::INT && b.type == ValueType::INT) {
+        return Value::Int(a.intVal * b.intVal);
+    } else if (a.type == ValueType::FLOAT || b.type == ValueType::FLOAT) {
+        double aVal = (a.type == ValueType::FLOAT) ? a.floatVal : a.intVal.toDouble();
+        double bVal = (b.type == ValueType::FLOAT) ? b.floatVal : b.intVal.toDouble();
+        return Value::Float(aVal * bVal);
+    } else if (a.type == ValueType::STRING && b.type == ValueType::INT) {
+        std::string result;
+        BigInteger count = b.intVal;
+        BigInteger zero(0);
+        while (count > zero) {
+            result += a.strVal;
+            count = count - BigInteger(1);
+        }
+        return Value::String(result);
+    } else if (a.type == ValueType::INT && b.type == ValueType::STRING) {
+        return performMul(b, a);
+    }
+    return Value::None();
+}
+
+Value performDiv(const Value& a, const Value& b) {
+    double aVal = (a.type == ValueType::FLOAT) ? a.floatVal : a.intVal.toDouble();
+    double bVal = (b.type == ValueType::FLOAT) ? b.floatVal : b.intVal.toDouble();
+    return Value::Float(aVal / bVal);
+}
+
+Value performFloorDiv(const Value& a, const Value& b) {
+    if (a.type == ValueType::INT && b.type == ValueType::INT) {
+        BigInteger quotient = a.intVal;
+        BigInteger remainder;
+        floorDivMod(quotient, b.intVal, remainder);
+        return Value::Int(std::move(quotient));
+    } else {
+        double aVal = (a.type == ValueType::FLOAT) ? a.floatVal : a.intVal.toDouble();
+        double bVal = (b.type == ValueType::FLOAT) ? b.floatVal : b.intVal.toDouble();
+        return Value::Float(std::floor(aVal / bVal));
+    }
+}
+
+Value performMod(const Value& a, const Value& b) {
+    if (a.type == ValueType::INT && b.type == ValueType::INT) {
+        BigInteger quotient = a.intVal;
+        BigInteger remainder;
+        floorDivMod(quotient, b.intVal, remainder);
+        return Value::Int(std::move(remainder));
+    } else {
+        double aVal = (a.type == ValueType::FLOAT) ? a.floatVal : a.intVal.toDouble();
+        double bVal = (b.type == ValueType::FLOAT) ? b.floatVal : b.intVal.toDouble();
+        return Value::Float(aVal - std::floor(aVal / bVal) * bVal);
+    }
+}
+
+bool performCompare(CompareOp op, const Value& a, const Value& b) {
+    switch (op) {
+        case CompareOp::EQ:
+            if (a.type == b.type) {
+                if (a.type == ValueType::INT) return a.intVal == b.intVal;
+                if (a.type == ValueType::FLOAT) return a.floatVal == b.floatVal;
+                if (a.type == ValueType::STRING) return a.strVal == b.strVal;
+                if (a.type == ValueType::BOOL) return a.boolVal == b.boolVal;
+                return a.type == ValueType::NONE;
+            } else if (a.type == ValueType::INT && b.type == ValueType::FLOAT) {
+                return a.intVal.compare(b.floatVal) == 0;
+            } else if (a.type == ValueType::FLOAT && b.type == ValueType::INT) {
+                return b.intVal.compare(a.floatVal) == 0;
+            }
+            return false;
+        case CompareOp::NE:
+            return !performCompare(CompareOp::EQ, a, b);
+        case CompareOp::LT:
+            if (a.type == ValueType::INT && b.type == ValueType::INT) {
+                return a.intVal < b.intVal;
+            } else if (a.type == ValueType::FLOAT && b.type == ValueType::FLOAT) {
+                return a.floatVal < b.floatVal;
+            } else if (a.type == ValueType::INT && b.type == ValueType::FLOAT) {
+                // Compare exactly: converting a big int to double would round it
+                return a.intVal.compare(b.floatVal) == -1;
+            } else if (a.type == ValueType::FLOAT && b.type == ValueType::INT) {
+                return b.intVal.compare(a.floatVal) == 1;
+            } else if (a.type == ValueType::STRING && b.type == ValueType::STRING) {
+                return a.strVal < b.strVal;
+            }
+            return false;
+        case CompareOp::GT:
+            return performCompare(CompareOp::LT, b, a);
+        case CompareOp::LE:
+            return !performCompare(CompareOp::LT, b, a);
+        case CompareOp::GE:
+            return !performCompare(CompareOp::LT, a, b);
+    }
+    return false;
+}
+
+Value convertToInt(const Value& v) {
+    if (v.type == ValueType::INT) return v;
+    if (v.type == ValueType::FLOAT) return Value::Int(BigInteger::fromDouble(std::trunc(v.floatVal)));
+    if (v.type == ValueType::BOOL) return Value::Int(BigInteger(v.boolVal ? 1 : 0));
+    if (v.type == ValueType::STRING) {
+        return Value::Int(BigInteger(v.strVal));
+    }
+    return Value::Int(BigInteger(0));
+}
+
+Value convertToFloat(const Value& v) {
+    if (v.type == ValueType::FLOAT) return v;
+    if (v.type == ValueType::INT) return Value::Float(v.intVal.toDouble());
+    if (v.type == ValueType::BOOL) return Value::Float(v.boolVal ? 1.0 : 0.0);
+    if (v.type == ValueType::STRING) {
+        return Value::Float(std::stod(v.strVal));
+    }
+    return Value::Float(0.0);
+}
+
+Value convertToStr(const Value& v) {
+    if (v.type == ValueType::STRING) return v;
+    return Value::String(v.toString());
+}
+
+Value convertToBool(const Value& v) {
+    return Value::Bool(v.toBool());
+}
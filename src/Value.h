@@ -0,0 +1,258 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_VALUE_H
+#define PYTHON_INTERPRETER_VALUE_H
+
+#include "BigInteger.h"
+#include "PoolAllocator.h"
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+enum class ValueType {
+    NONE,
+    BOOL,
+    INT,
+    FLOAT,
+    STRING,
+    TUPLE,
+    FUNCTION
+};
+
+class Value {
+public:
+    ValueType type;
+    bool boolVal;
+    BigInteger intVal;
+    double floatVal;
+    std::string strVal;
+    // Tuples are immutable, so copies of a tuple Value share one element
+    // buffer; null stands for the empty tuple
+    std::shared_ptr<const std::vector<Value>> tupleVal;
+
+    Value() : type(ValueType::NONE) {}
+
+    // Only the member type selects is copied or moved; the others keep
+    // whatever they held, so a VM register that changes type keeps its
+    // buffers for the next value of the old type
+    Value(const Value& other) : type(other.type) {
+        copyPayload(other);
+    }
+
+    Value(Value&& other) noexcept : type(other.type) {
+        movePayload(other);
+    }
+
+    Value& operator=(const Value& other) {
+        if (this != &other) {
+            type = other.type;
+            copyPayload(other);
+        }
+        return *this;
+    }
+
+    Value& operator=(Value&& other) noexcept {
+        if (this != &other) {
+            type = other.type;
+            movePayload(other);
+        }
+        return *this;
+    }
+
+    // Values boxed on the heap come from the VALUES pool
+    static void* operator new(size_t size) {
+        return SizeClassPool::allocate(size, RuntimeStats::VALUES);
+    }
+
+    static void operator delete(void* block, size_t size) noexcept {
+        SizeClassPool::deallocate(block, size, RuntimeStats::VALUES);
+    }
+
+    static Value None() {
+        return Value();
+    }
+
+    static Value Bool(bool b) {
+        Value v;
+        v.type = ValueType::BOOL;
+        v.boolVal = b;
+        return v;
+    }
+
+    static Value Int(BigInteger i) {
+        Value v;
+        v.type = ValueType::INT;
+        v.intVal = std::move(i);
+        return v;
+    }
+
+    static Value Float(double f) {
+        Value v;
+        v.type = ValueType::FLOAT;
+        v.floatVal = f;
+        return v;
+    }
+
+    static Value String(std::string s) {
+        Value v;
+        v.type = ValueType::STRING;
+        v.strVal = std::move(s);
+        return v;
+    }
+
+    static Value Tuple(std::vector<Value> t) {
+        Value v;
+        v.type = ValueType::TUPLE;
+        if (!t.empty()) {
+            v.tupleVal = std::allocate_shared<std::vector<Value>>(
+                PoolAllocator<std::vector<Value>, RuntimeStats::VALUES>(), std::move(t));
+        }
+        return v;
+    }
+
+    const std::vector<Value>& tupleItems() const {
+        static const std::vector<Value> empty;
+        return tupleVal ? *tupleVal : empty;
+    }
+
+    std::string toString() const {
+        switch (type) {
+            case ValueType::NONE:
+                return "None";
+            case ValueType::BOOL:
+                return boolVal ? "True" : "False";
+            case ValueType::INT:
+                return intVal.toString();
+            case ValueType::FLOAT: {
+                // Check if it's a whole number
+                if (floatVal == std::floor(floatVal) && std::abs(floatVal) < 1e15) {
+                    std::ostringstream oss;
+                    oss << std::fixed << std::setprecision(1) << floatVal;
+                    return oss.str();
+                } else {
+                    std::ostringstream oss;
+                    oss << std::fixed << std::setprecision(6) << floatVal;
+                    std::string result = oss.str();
+                    // Remove trailing zeros
+                    size_t dotPos = result.find('.');
+                    if (dotPos != std::string::npos) {
+                        size_t lastNonZero = result.find_last_not_of('0');
+                        if (lastNonZero > dotPos) {
+                            result = result.substr(0, lastNonZero + 1);
+                        }
+                    }
+                    return result;
+                }
+            }
+            case ValueType::STRING:
+                return strVal;
+            case ValueType::TUPLE: {
+                const std::vector<Value>& items = tupleItems();
+                if (items.empty()) return "()";
+                std::string result = "(";
+                for (size_t i = 0; i < items.size(); i++) {
+                    if (i > 0) result += ", ";
+                    result += items[i].toString();
+                }
+                if (items.size() == 1) result += ",";
+                result += ")";
+                return result;
+            }
+            default:
+                return "";
+        }
+    }
+
+    bool toBool() const {
+        switch (type) {
+            case ValueType::NONE:
+                return false;
+            case ValueType::BOOL:
+                return boolVal;
+            case ValueType::INT:
+                return !intVal.isZero();
+            case ValueType::FLOAT:
+                return floatVal != 0.0;
+            case ValueType::STRING:
+                return !strVal.empty();
+            case ValueType::TUPLE:
+                return tupleVal != nullptr;
+            default:
+                return false;
+        }
+    }
+
+private:
+    void copyPayload(const Value& other) {
+        switch (other.type) {
+            case ValueType::BOOL:
+                boolVal = other.boolVal;
+                break;
+            case ValueType::INT:
+                intVal = other.intVal;
+                break;
+            case ValueType::FLOAT:
+                floatVal = other.floatVal;
+                break;
+            case ValueType::STRING:
+                strVal = other.strVal;
+                break;
+            case ValueType::TUPLE:
+                tupleVal = other.tupleVal;
+                break;
+            default:
+                break;
+        }
+    }
+
+    void movePayload(Value& other) noexcept {
+        switch (other.type) {
+            case ValueType::BOOL:
+                boolVal = other.boolVal;
+                break;
+            case ValueType::INT:
+                intVal = std::move(other.intVal);
+                break;
+            case ValueType::FLOAT:
+                floatVal = other.floatVal;
+                break;
+            case ValueType::STRING:
+                strVal = std::move(other.strVal);
+                break;
+            case ValueType::TUPLE:
+                tupleVal = std::move(other.tupleVal);
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+enum class BinaryOp : uint8_t { ADD, SUB, MUL, DIV, FLOORDIV, MOD };
+enum class CompareOp : uint8_t { LT, GT, LE, GE, EQ, NE };
+
+// The operators of the language on Values, shared by the compiler's constant
+// folding and the virtual machine's generic (unquickened) paths
+void floorDivMod(BigInteger& dividend, const BigInteger& divisor, BigInteger& remainder);
+
+// target = target op right for ints, reusing target's limbs; false when
+// op or the operand types need the generic perform* path
+bool performInPlace(Value& target, const Value& right, BinaryOp op);
+Value performBinary(BinaryOp op, const Value& a, const Value& b);
+Value performAdd(const Value& a, const Value& b);
+Value performSub(const Value& a, const Value& b);
+Value performMul(const Value& a, const Value& b);
+Value performDiv(const Value& a, const Value& b);
+Value performFloorDiv(const Value& a, const Value& b);
+Value performMod(const Value& a, const Value& b);
+bool performCompare(CompareOp op, const Value& a, const Value& b);
+
+Value convertToInt(const Value& v);
+Value convertToFloat(const Value& v);
+Value convertToStr(const Value& v);
+Value convertToBool(const Value& v);
+
+#endif//PYTHON_INTERPRETER_VALUE_H
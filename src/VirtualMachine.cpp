@@ -0,0 +1,1014 @@
+#include "VirtualMachine.h"
+#include "FunctionProfiler.h"
+#include "LineProfiler.h"
+#include "RuntimeStats.h"
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+// GCC and Clang can jump straight to the address stored in the next
+// instruction; anything else dispatches through a switch
+#if defined(__GNUC__)
+#define THREADED_DISPATCH 1
+#endif
+
+#ifdef THREADED_DISPATCH
+#define TARGET(name) L_##name:
+#define DISPATCH() goto *ip->handler
+#define REWRITE(name) (ip->op = Opcode::name, ip->handler = labels[(size_t)Opcode::name])
+#else
+#define TARGET(name) case Opcode::name:
+#define DISPATCH() goto dispatch
+#define REWRITE(name) (ip->op = Opcode::name)
+#endif
+
+// Handlers leave through DISPATCH, which under threaded dispatch is a
+// computed goto: it runs no destructors for the handler's locals, so a
+// local that owns memory lives in an inner block closed before then
+#define NEXT() \
+    do { \
+        ip++; \
+        DISPATCH(); \
+    } while (0)
+
+#define JUMP_TO(target) \
+    do { \
+        ip = code->instructions.data() + (target); \
+        DISPATCH(); \
+    } while (0)
+
+// The Value an operand names in the running call
+#define OPERAND(operand) \
+    (*((operand) < GLOBAL_OPERAND     ? base + (operand) \
+       : (operand) < CONSTANT_OPERAND ? globalValues + ((operand) - GLOBAL_OPERAND) \
+                                      : constants + ((operand) - CONSTANT_OPERAND)))
+
+#define OPERANDS() \
+    Value& result = OPERAND(ip->a); \
+    const Value& left = OPERAND(ip->b); \
+    const Value& right = OPERAND(ip->c)
+
+#define BOTH(kind) (left.type == ValueType::kind && right.type == ValueType::kind)
+
+// A comparison either stores its result in a or, fused with a branch,
+// jumps to a when the result is false
+#define COMPARE_RESULT(holds) \
+    do { \
+        bool value = (holds); \
+        if (ip->sub & BRANCH_IF_FALSE) { \
+            if (!value) JUMP_TO(ip->a); \
+        } else { \
+            Value& result = OPERAND(ip->a); \
+            result.type = ValueType::BOOL; \
+            result.boolVal = value; \
+        } \
+        NEXT(); \
+    } while (0)
+
+// Unseen operator sites pick a specialized form from their first operands
+#define QUICKEN(intForm, floatForm, genericForm) QUICKEN_TYPED(intForm, floatForm, genericForm, genericForm)
+
+#define QUICKEN_TYPED(intForm, floatForm, stringForm, genericForm) \
+    do { \
+        const Value& left = OPERAND(ip->b); \
+        const Value& right = OPERAND(ip->c); \
+        if (BOTH(INT)) { \
+            REWRITE(intForm); \
+        } else if (BOTH(FLOAT)) { \
+            REWRITE(floatForm); \
+        } else if (BOTH(STRING)) { \
+            REWRITE(stringForm); \
+        } else { \
+            REWRITE(genericForm); \
+        } \
+        DISPATCH(); \
+    } while (0)
+
+// statement updates target, which starts as a copy of the left int, by the
+// right one; the result may be either operand, so a result that is the
+// right operand is computed aside and swapped in
+#define INT_UPDATE(statement) \
+    do { \
+        if (&result == &right) { \
+            scratch = left.intVal; \
+            BigInteger& target = scratch; \
+            statement; \
+            std::swap(result.intVal, scratch); \
+        } else { \
+            if (&result != &left) { \
+                result.type = ValueType::INT; \
+                result.intVal = left.intVal; \
+            } \
+            BigInteger& target = result.intVal; \
+            statement; \
+        } \
+    } while (0)
+
+// A specialized form whose guard fails falls back to the generic form for
+// good
+#define INT_BINARY(statement) \
+    do { \
+        OPERANDS(); \
+        if (BOTH(INT)) { \
+            INT_UPDATE(statement); \
+            NEXT(); \
+        } \
+        REWRITE(BINARY_GENERIC); \
+        DISPATCH(); \
+    } while (0)
+
+// Operands the compiler proved are ints need no guard. While both fit in
+// an int64 (x and y), fits computes value natively and says whether it did
+// so without overflow; otherwise statement works on the BigIntegers.
+#define I64_BINARY(fits, statement) \
+    do { \
+        OPERANDS(); \
+        int64_t x, y, value; \
+        if (left.intVal.toInt64(x) && right.intVal.toInt64(y) && (fits)) { \
+            result.type = ValueType::INT; \
+            result.intVal.assign(value); \
+        } else { \
+            INT_UPDATE(statement); \
+        } \
+        NEXT(); \
+    } while (0)
+
+#define FLOAT_BINARY(op) \
+    do { \
+        OPERANDS(); \
+        if (BOTH(FLOAT)) { \
+            double value = left.floatVal op right.floatVal; \
+            result.type = ValueType::FLOAT; \
+            result.floatVal = value; \
+            NEXT(); \
+        } \
+        REWRITE(BINARY_GENERIC); \
+        DISPATCH(); \
+    } while (0)
+
+#define TYPED_COMPARE(kind, field, op) \
+    do { \
+        const Value& left = OPERAND(ip->b); \
+        const Value& right = OPERAND(ip->c); \
+        if (BOTH(kind)) COMPARE_RESULT(left.field op right.field); \
+        REWRITE(COMPARE_GENERIC); \
+        DISPATCH(); \
+    } while (0)
+
+#define I64_COMPARE(op) \
+    do { \
+        const Value& left = OPERAND(ip->b); \
+        const Value& right = OPERAND(ip->c); \
+        int64_t x, y; \
+        if (left.intVal.toInt64(x) && right.intVal.toInt64(y)) COMPARE_RESULT(x op y); \
+        COMPARE_RESULT(left.intVal op right.intVal); \
+    } while (0)
+
+namespace {
+
+// toInt64 gives magnitudes below 10^18, so sums and differences always fit
+// and products do when both factors are below 2^31.5
+constexpr int64_t PRODUCT_LIMIT = 3037000499;
+
+bool multiplyFits(int64_t x, int64_t y, int64_t& product) {
+    if (x > PRODUCT_LIMIT || x < -PRODUCT_LIMIT || y > PRODUCT_LIMIT || y < -PRODUCT_LIMIT) {
+        return false;
+    }
+    product = x * y;
+    return true;
+}
+
+// Python's floor division and modulo; a zero divisor is left to the
+// BigInteger path, which reports it
+bool floorDivideFits(int64_t x, int64_t y, int64_t& quotient) {
+    if (y == 0) {
+        return false;
+    }
+    quotient = x / y;
+    if (x % y != 0 && (x % y < 0) != (y < 0)) {
+        quotient--;
+    }
+    return true;
+}
+
+bool moduloFits(int64_t x, int64_t y, int64_t& remainder) {
+    if (y == 0) {
+        return false;
+    }
+    remainder = x % y;
+    if (remainder != 0 && (remainder < 0) != (y < 0)) {
+        remainder += y;
+    }
+    return true;
+}
+
+}
+
+void VirtualMachine::run() {
+#ifdef THREADED_DISPATCH
+    static const void* const labels[] = {
+#define PYTHON_INTERPRETER_OPCODE_LABEL(name) &&L_##name,
+        PYTHON_INTERPRETER_OPCODES(PYTHON_INTERPRETER_OPCODE_LABEL)
+#undef PYTHON_INTERPRETER_OPCODE_LABEL
+    };
+    for (auto& codeObject : program.codeObjects) {
+        for (Instruction& instruction : codeObject->instructions) {
+            instruction.handler = labels[(size_t)instruction.op];
+        }
+    }
+#endif
+
+    globals.resize(program.globalNames.size());
+    shadowing.assign(program.globalNames.size(), 0);
+    functions.resize(program.globalNames.size());
+    builtins.resize(program.globalNames.size());
+    for (uint32_t name = 0; name < program.globalNames.size(); name++) {
+        builtins[name] = builtinNamed(program.globalNames[name]);
+        globalIndices[program.globalNames[name]] = name;
+    }
+    Value* const globalValues = globals.data();
+
+    CodeObject* code = program.module;
+    Instruction* ip = code->instructions.data();
+    Value* constants = code->constants.data();
+    registers.resize(std::max<size_t>(1024, code->registerCount));
+    Value* base = registers.data();
+    // Reused by floor division and modulo, so ints need no fresh remainder,
+    // and by int operators whose result overwrites their right operand
+    BigInteger remainder;
+    BigInteger scratch;
+
+    // State of the call being made, shared by the call instructions
+    CallSite* site = nullptr;
+    Value* args = nullptr;
+    const std::string* calleeName = nullptr;
+    std::string indirectName;
+    Builtin builtin = Builtin::NONE;
+    FunctionDef* function = nullptr;
+
+#ifdef THREADED_DISPATCH
+    DISPATCH();
+#else
+dispatch:
+    switch (ip->op) {
+#endif
+
+    TARGET(MOVE) {
+        OPERAND(ip->a) = OPERAND(ip->b);
+        NEXT();
+    }
+
+    TARGET(LOAD_DYNAMIC) {
+        OPERAND(ip->a) = variable(ip->b);
+        NEXT();
+    }
+
+    TARGET(LOAD_CALLABLE) {
+        if (builtins[ip->b] != Builtin::NONE || functions[ip->b].code) {
+            OPERAND(ip->a) = Value::String(program.globalNames[ip->b]);  // functions evaluate to their name
+        } else {
+            OPERAND(ip->a) = variable(ip->b);
+        }
+        NEXT();
+    }
+
+    TARGET(ASSIGN) {
+        assign(code->assignments[ip->a], base, base + ip->b, ip->c);
+        NEXT();
+    }
+
+    TARGET(BUILD_TUPLE) {
+        {
+            std::vector<Value> items(std::make_move_iterator(base + ip->b),
+                                     std::make_move_iterator(base + ip->b + ip->c));
+            OPERAND(ip->a) = Value::Tuple(std::move(items));
+        }
+        NEXT();
+    }
+
+    TARGET(FORMAT) {
+        OPERAND(ip->a) = Value::String(formatValues(base + ip->b, ip->c));
+        NEXT();
+    }
+
+    TARGET(BUILD_STRING) {
+        {
+            Value* parts = base + ip->b;
+            std::string text = std::move(parts[0].strVal);
+            for (uint32_t i = 1; i < ip->c; i++) {
+                text += parts[i].strVal;
+            }
+            OPERAND(ip->a) = Value::String(std::move(text));
+        }
+        NEXT();
+    }
+
+    TARGET(NOT) {
+        bool value = !OPERAND(ip->b).toBool();
+        Value& result = OPERAND(ip->a);
+        result.type = ValueType::BOOL;
+        result.boolVal = value;
+        NEXT();
+    }
+
+    TARGET(NEGATE) {
+        Value& result = OPERAND(ip->a);
+        result = OPERAND(ip->b);
+        if (result.type == ValueType::INT) {
+            result.intVal.negate();
+        } else if (result.type == ValueType::FLOAT) {
+            result.floatVal = -result.floatVal;
+        }
+        NEXT();
+    }
+
+    TARGET(JUMP) {
+        JUMP_TO(ip->a);
+    }
+
+    TARGET(JUMP_IF_FALSE) {
+        if (!OPERAND(ip->b).toBool()) JUMP_TO(ip->a);
+        NEXT();
+    }
+
+    TARGET(JUMP_IF_TRUE) {
+        if (OPERAND(ip->b).toBool()) JUMP_TO(ip->a);
+        NEXT();
+    }
+
+    TARGET(LOOP) {
+        // The count stops at HOT_LOOP, so a loop the Jit declined or gave
+        // back is never compiled again
+        if (ip->b < Jit::HOT_LOOP && ++ip->b == Jit::HOT_LOOP && Jit::enabled()) {
+            uint32_t loop = jit.compile(*code, ip->a, ip - code->instructions.data());
+            if (loop != Jit::NONE) {
+                ip->c = loop;
+                REWRITE(LOOP_NATIVE);
+            }
+        }
+        JUMP_TO(ip->a);
+    }
+
+    TARGET(LOOP_NATIVE) {
+        // The native code runs the loop from its start, until it exits or
+        // reaches an instruction it leaves to the interpreter
+        uint32_t resume = ip->a;
+        jit.run(ip->c, base, globalValues, resume);
+        if (jit.exhausted(ip->c)) {
+            REWRITE(LOOP);
+        }
+        JUMP_TO(resume);
+    }
+
+    TARGET(ADD) {
+        QUICKEN_TYPED(ADD_INT, ADD_FLOAT, ADD_STRING, BINARY_GENERIC);
+    }
+
+    TARGET(ADD_INT) {
+        INT_BINARY(target += right.intVal);
+    }
+
+    TARGET(ADD_FLOAT) {
+        FLOAT_BINARY(+);
+    }
+
+    TARGET(ADD_STRING) {
+        // s = s + t appends to s rather than building a new string
+        OPERANDS();
+        if (BOTH(STRING)) {
+            if (&result == &left) {
+                result.strVal += right.strVal;
+            } else {
+                result = Value::String(left.strVal + right.strVal);
+            }
+            NEXT();
+        }
+        REWRITE(BINARY_GENERIC);
+        DISPATCH();
+    }
+
+    TARGET(SUB) {
+        QUICKEN(SUB_INT, SUB_FLOAT, BINARY_GENERIC);
+    }
+
+    TARGET(SUB_INT) {
+        INT_BINARY(target -= right.intVal);
+    }
+
+    TARGET(SUB_FLOAT) {
+        FLOAT_BINARY(-);
+    }
+
+    TARGET(MUL) {
+        QUICKEN(MUL_INT, MUL_FLOAT, BINARY_GENERIC);
+    }
+
+    TARGET(MUL_INT) {
+        INT_BINARY(target *= right.intVal);
+    }
+
+    TARGET(MUL_FLOAT) {
+        FLOAT_BINARY(*);
+    }
+
+    TARGET(DIV) {
+        // int / int is a float, so only float operands specialize
+        QUICKEN(BINARY_GENERIC, DIV_FLOAT, BINARY_GENERIC);
+    }
+
+    TARGET(DIV_FLOAT) {
+        FLOAT_BINARY(/);
+    }
+
+    TARGET(FLOORDIV) {
+        QUICKEN(FLOORDIV_INT, BINARY_GENERIC, BINARY_GENERIC);
+    }
+
+    TARGET(FLOORDIV_INT) {
+        INT_BINARY(floorDivMod(target, right.intVal, remainder));
+    }
+
+    TARGET(MOD) {
+        QUICKEN(MOD_INT, BINARY_GENERIC, BINARY_GENERIC);
+    }
+
+    TARGET(MOD_INT) {
+        INT_BINARY(floorDivMod(target, right.intVal, remainder); std::swap(target, remainder));
+    }
+
+    TARGET(BINARY_GENERIC) {
+        OPERANDS();
+        BinaryOp op = (BinaryOp)ip->sub;
+        if (&result != &left || &left == &right || !performInPlace(result, right, op)) {
+            Value value = performBinary(op, left, right);
+            result = std::move(value);
+        }
+        NEXT();
+    }
+
+    TARGET(ADD_I64) {
+        I64_BINARY((value = x + y, true), target += right.intVal);
+    }
+
+    TARGET(SUB_I64) {
+        I64_BINARY((value = x - y, true), target -= right.intVal);
+    }
+
+    TARGET(MUL_I64) {
+        I64_BINARY(multiplyFits(x, y, value), target *= right.intVal);
+    }
+
+    TARGET(FLOORDIV_I64) {
+        I64_BINARY(floorDivideFits(x, y, value), floorDivMod(target, right.intVal, remainder));
+    }
+
+    TARGET(MOD_I64) {
+        I64_BINARY(moduloFits(x, y, value), floorDivMod(target, right.intVal, remainder); std::swap(target, remainder));
+    }
+
+    TARGET(LT) {
+        QUICKEN_TYPED(LT_INT, LT_FLOAT, LT_STRING, COMPARE_GENERIC);
+    }
+
+    TARGET(LT_INT) {
+        TYPED_COMPARE(INT, intVal, <);
+    }
+
+    TARGET(LT_FLOAT) {
+        TYPED_COMPARE(FLOAT, floatVal, <);
+    }
+
+    TARGET(LT_STRING) {
+        TYPED_COMPARE(STRING, strVal, <);
+    }
+
+    TARGET(GT) {
+        QUICKEN_TYPED(GT_INT, GT_FLOAT, GT_STRING, COMPARE_GENERIC);
+    }
+
+    TARGET(GT_INT) {
+        TYPED_COMPARE(INT, intVal, >);
+    }
+
+    TARGET(GT_FLOAT) {
+        TYPED_COMPARE(FLOAT, floatVal, >);
+    }
+
+    TARGET(GT_STRING) {
+        TYPED_COMPARE(STRING, strVal, >);
+    }
+
+    TARGET(LE) {
+        QUICKEN_TYPED(LE_INT, LE_FLOAT, LE_STRING, COMPARE_GENERIC);
+    }
+
+    TARGET(LE_INT) {
+        TYPED_COMPARE(INT, intVal, <=);
+    }
+
+    TARGET(LE_FLOAT) {
+        TYPED_COMPARE(FLOAT, floatVal, <=);
+    }
+
+    TARGET(LE_STRING) {
+        TYPED_COMPARE(STRING, strVal, <=);
+    }
+
+    TARGET(GE) {
+        QUICKEN_TYPED(GE_INT, GE_FLOAT, GE_STRING, COMPARE_GENERIC);
+    }
+
+    TARGET(GE_INT) {
+        TYPED_COMPARE(INT, intVal, >=);
+    }
+
+    TARGET(GE_FLOAT) {
+        TYPED_COMPARE(FLOAT, floatVal, >=);
+    }
+
+    TARGET(GE_STRING) {
+        TYPED_COMPARE(STRING, strVal, >=);
+    }
+
+    TARGET(EQ) {
+        QUICKEN_TYPED(EQ_INT, EQ_FLOAT, EQ_STRING, COMPARE_GENERIC);
+    }
+
+    TARGET(EQ_INT) {
+        TYPED_COMPARE(INT, intVal, ==);
+    }
+
+    TARGET(EQ_FLOAT) {
+        TYPED_COMPARE(FLOAT, floatVal, ==);
+    }
+
+    TARGET(EQ_STRING) {
+        TYPED_COMPARE(STRING, strVal, ==);
+    }
+
+    TARGET(NE) {
+        QUICKEN_TYPED(NE_INT, NE_FLOAT, NE_STRING, COMPARE_GENERIC);
+    }
+
+    TARGET(NE_INT) {
+        TYPED_COMPARE(INT, intVal, !=);
+    }
+
+    TARGET(NE_FLOAT) {
+        TYPED_COMPARE(FLOAT, floatVal, !=);
+    }
+
+    TARGET(NE_STRING) {
+        TYPED_COMPARE(STRING, strVal, !=);
+    }
+
+    TARGET(COMPARE_GENERIC) {
+        COMPARE_RESULT(performCompare((CompareOp)(ip->sub & ~BRANCH_IF_FALSE), OPERAND(ip->b), OPERAND(ip->c)));
+    }
+
+    TARGET(LT_I64) {
+        I64_COMPARE(<);
+    }
+
+    TARGET(GT_I64) {
+        I64_COMPARE(>);
+    }
+
+    TARGET(LE_I64) {
+        I64_COMPARE(<=);
+    }
+
+    TARGET(GE_I64) {
+        I64_COMPARE(>=);
+    }
+
+    TARGET(EQ_I64) {
+        I64_COMPARE(==);
+    }
+
+    TARGET(NE_I64) {
+        I64_COMPARE(!=);
+    }
+
+    TARGET(CALL) {
+        // Builtins take precedence over defs, and a name a def has bound
+        // stays bound to one, so once either answers to the name the site
+        // calls it directly from then on
+        uint32_t name = code->calls[ip->b].name;
+        if (builtins[name] != Builtin::NONE) {
+            REWRITE(CALL_BUILTIN);
+            DISPATCH();
+        }
+        if (functions[name].code) {
+            REWRITE(CALL_FUNCTION);
+            DISPATCH();
+        }
+        // A variable holding a function's name calls that function; any
+        // other value is the result
+        const Value& variableValue = variable(name);
+        if (variableValue.type != ValueType::STRING) {
+            OPERAND(ip->a) = variableValue;
+            NEXT();
+        }
+        site = &code->calls[ip->b];
+        args = base + ip->c;
+        indirectName = variableValue.strVal;
+        goto call_named;
+    }
+
+    TARGET(CALL_BUILTIN) {
+        site = &code->calls[ip->b];
+        args = base + ip->c;
+        calleeName = &program.globalNames[site->name];
+        builtin = builtins[site->name];
+        goto call_builtin;
+    }
+
+    TARGET(CALL_FUNCTION) {
+        site = &code->calls[ip->b];
+        args = base + ip->c;
+        calleeName = &program.globalNames[site->name];
+        function = &functions[site->name];
+        goto call_function;
+    }
+
+    TARGET(CALL_VALUE) {
+        site = &code->calls[ip->b];
+        args = base + ip->c;
+        if (args[-1].type != ValueType::STRING) {
+            OPERAND(ip->a) = args[-1];
+            NEXT();
+        }
+        indirectName = args[-1].strVal;
+        goto call_named;
+    }
+
+    TARGET(TAIL_CALL) {
+        // While the name still calls the running def, the arguments become
+        // its parameters and it starts over in the same frame; otherwise
+        // this is a call, and the RETURN after it returns the result
+        site = &code->calls[ip->b];
+        args = base + ip->c;
+        calleeName = &program.globalNames[site->name];
+        function = &functions[site->name];
+        if (function->code != frames.back().function) {
+            goto call_function;
+        }
+        // Keyword arguments are bound from where they were computed, so a
+        // parameter the call leaves unbound keeps its value, which is what
+        // its name reads as at the call
+        std::move(args, args + site->positional, base);
+        bindArguments(*function, *site, base, args + site->positional);
+        if (FunctionProfiler::enabled()) {
+            FunctionProfiler::leave();
+            FunctionProfiler::enter(*calleeName);
+        }
+        code = codeFor(*function->code, base);
+        constants = code->constants.data();
+        ip = code->instructions.data();
+        DISPATCH();
+    }
+
+    call_named: {
+        // A name computed at run time is looked up on each call
+        calleeName = &indirectName;
+        builtin = builtinNamed(indirectName);
+        if (builtin != Builtin::NONE) {
+            goto call_builtin;
+        }
+        auto found = globalIndices.find(indirectName);
+        if (found == globalIndices.end() || !functions[found->second].code) {
+            if (FunctionProfiler::enabled()) {
+                FunctionProfiler::enter(indirectName);
+                FunctionProfiler::leave();
+            }
+            OPERAND(ip->a) = Value::None();
+            NEXT();
+        }
+        function = &functions[found->second];
+        goto call_function;
+    }
+
+    call_builtin: {
+        OPERAND(ip->a) = callBuiltinFunction(builtin, *calleeName, args, site->positional);
+        NEXT();
+    }
+
+    call_function: {
+        // The callee's window starts at the arguments
+        const FunctionCode& callee = *function->code;
+        size_t calleeBase = args - registers.data();
+        size_t callerBase = base - registers.data();
+        size_t needed = calleeBase + callee.code->registerCount;
+        if (needed > registers.size()) {
+            registers.resize(std::max(registers.size() * 2, needed));
+            base = registers.data() + callerBase;
+        }
+
+        // Arguments are bound before the callee's frame is pushed, so an
+        // unbound parameter reads its name as the caller sees it
+        Value* window = registers.data() + calleeBase;
+        bindArguments(*function, *site, window, window + site->positional);
+
+        // A pure def has nothing to run for arguments it has seen before
+        bool memoized = callee.pure && MemoCache::enabled();
+        if (memoized) {
+            size_t count = callee.params.size();
+            size_t hash = MemoCache::hash(window, count);
+            if (const Value* cached = function->memo.find(window, count, hash)) {
+                if (FunctionProfiler::enabled()) {
+                    FunctionProfiler::enter(*calleeName);
+                    FunctionProfiler::leave();
+                }
+                OPERAND(ip->a) = *cached;
+                NEXT();
+            }
+            memoKeys.push_back(MemoKey{&function->memo, std::vector<Value>(window, window + count), hash});
+        }
+
+        frames.push_back(Frame{&callee, calleeBase, code, ip + 1, callerBase, ip->a, memoized});
+        for (uint32_t name : callee.paramNames) {
+            shadowing[name]++;
+        }
+        base = window;
+        if (FunctionProfiler::enabled()) {
+            FunctionProfiler::enter(*calleeName);
+        }
+
+        code = codeFor(callee, base);
+        constants = code->constants.data();
+        ip = code->instructions.data();
+        DISPATCH();
+    }
+
+    TARGET(MAKE_FUNCTION) {
+        const FunctionCode& made = program.functions[ip->a];
+        // Results cached under the old def, or under a call that found no
+        // def by this name, may no longer hold
+        if (MemoCache::enabled()) {
+            for (FunctionDef& defined : functions) {
+                if (defined.code) {
+                    defined.memo.clear();
+                }
+            }
+        }
+        FunctionDef& def = functions[made.global];
+        def.code = &made;
+        Value* defaults = base + ip->b;
+        def.defaults.assign(std::make_move_iterator(defaults), std::make_move_iterator(defaults + made.defaultCount));
+        NEXT();
+    }
+
+    TARGET(RETURN) {
+        if (frames.empty()) {
+            return;  // a return at module level ends the program
+        }
+        if (FunctionProfiler::enabled()) {
+            FunctionProfiler::leave();
+        }
+        Frame& frame = frames.back();
+        for (uint32_t name : frame.function->paramNames) {
+            shadowing[name]--;
+        }
+
+        // A register of the finished call is dead, so its value is taken
+        Value& value = OPERAND(ip->a);
+        Value* callerBase = registers.data() + frame.callerBase;
+        Value& result = isRegister(frame.result) ? callerBase[frame.result]
+                                                 : globalValues[frame.result - GLOBAL_OPERAND];
+        if (frame.memoized) {
+            MemoKey& key = memoKeys.back();
+            key.cache->insert(std::move(key.arguments), key.hash, value);
+            memoKeys.pop_back();
+        }
+        if (isRegister(ip->a)) {
+            std::swap(result, value);
+        } else {
+            result = value;
+        }
+
+        code = frame.callerCode;
+        constants = code->constants.data();
+        ip = frame.returnTo;
+        base = callerBase;
+        frames.pop_back();
+        DISPATCH();
+    }
+
+    TARGET(LINE_ENTER) {
+        LineProfiler::enter(code->lines[ip->a]);
+        NEXT();
+    }
+
+    TARGET(LINE_EXIT) {
+        LineProfiler::leave();
+        NEXT();
+    }
+
+    TARGET(LINE_ITERATION) {
+        LineProfiler::countIteration(code->lines[ip->a]);
+        NEXT();
+    }
+
+    TARGET(HALT) {
+        return;
+    }
+
+#ifndef THREADED_DISPATCH
+        default:
+            return;
+    }
+#endif
+}
+
+#undef I64_COMPARE
+#undef I64_BINARY
+#undef TYPED_COMPARE
+#undef FLOAT_BINARY
+#undef INT_BINARY
+#undef INT_UPDATE
+#undef QUICKEN
+#undef QUICKEN_TYPED
+#undef COMPARE_RESULT
+#undef BOTH
+#undef OPERANDS
+#undef OPERAND
+#undef JUMP_TO
+#undef NEXT
+#undef REWRITE
+#undef DISPATCH
+#undef TARGET
+
+Value& VirtualMachine::variable(uint32_t name) {
+    if (shadowing[name]) {
+        for (size_t i = frames.size(); i-- > 0;) {
+            const std::vector<uint32_t>& params = frames[i].function->paramNames;
+            for (size_t j = 0; j < params.size(); j++) {
+                if (params[j] == name) {
+                    return registers[frames[i].base + j];
+                }
+            }
+        }
+    }
+    return globals[name];
+}
+
+void VirtualMachine::assign(const std::vector<std::vector<uint32_t>>& targets, Value* window, Value* values,
+                            size_t count) {
+    for (size_t i = 0; i < targets.size(); i++) {
+        const std::vector<uint32_t>& operands = targets[i];
+
+        // Handle tuple unpacking: a single tuple on the right is spread over
+        // several targets, while a single target keeps the tuple itself.
+        // The value's register keeps the tuple's buffer alive while targets
+        // are rebound.
+        bool unpack = operands.size() > 1 && count == 1 && values[0].type == ValueType::TUPLE;
+        const Value* source = unpack ? values[0].tupleItems().data() : values;
+        size_t available = unpack ? values[0].tupleItems().size() : count;
+
+        // Assign values; the last target list may take the values over
+        bool last = i + 1 == targets.size();
+        for (size_t j = 0; j < operands.size() && j < available; j++) {
+            Value& slot = isRegister(operands[j]) ? window[operands[j]] : globals[operands[j] - GLOBAL_OPERAND];
+            if (last && !unpack) {
+                std::swap(slot, values[j]);
+            } else {
+                slot = source[j];
+            }
+        }
+    }
+}
+
+void VirtualMachine::bindArguments(const FunctionDef& function, CallSite& site, Value* window, Value* keywords) {
+    // A missing parameter takes its default value; without one it takes the
+    // value its name has at the call, an outer call's parameter or else the
+    // global
+    const FunctionCode& callee = *function.code;
+    size_t params = callee.params.size();
+    size_t firstDefault = params - function.defaults.size();
+    auto bindMissing = [&](size_t param) {
+        window[param] = param >= firstDefault ? function.defaults[param - firstDefault]
+                                              : variable(callee.paramNames[param]);
+    };
+
+    if (site.keywords.empty()) {
+        for (size_t i = site.positional; i < params; i++) {
+            bindMissing(i);
+        }
+        return;
+    }
+
+    // Keyword arguments may sit in other parameters' registers, so they are
+    // moved aside before being put in their own
+    const BindingPlan& plan = planFor(site, callee);
+    size_t count = site.keywords.size();
+    if (staged.size() < count) {
+        staged.resize(count);
+    }
+    std::move(keywords, keywords + count, staged.begin());
+    for (size_t i = 0; i < count; i++) {
+        window[plan.keywordParams[i]] = std::move(staged[i]);
+    }
+    for (uint32_t param : plan.unbound) {
+        bindMissing(param);
+    }
+}
+
+const VirtualMachine::BindingPlan& VirtualMachine::planFor(CallSite& site, const FunctionCode& callee) {
+    if (site.plan != NO_PLAN && plans[site.plan].callee == &callee) {
+        return plans[site.plan];
+    }
+    // A site that calls another def than before replans in place
+    if (site.plan == NO_PLAN) {
+        site.plan = plans.size();
+        plans.emplace_back();
+    }
+    BindingPlan& plan = plans[site.plan];
+    const std::vector<std::string>& params = callee.params;
+    plan.callee = nullptr;
+    plan.keywordParams.clear();
+    plan.unbound.clear();
+
+    std::vector<bool> bound(params.size(), false);
+    for (const std::string& keyword : site.keywords) {
+        auto param = std::find(params.begin(), params.end(), keyword);
+        if (param == params.end()) {
+            throw std::runtime_error(callee.name + "() got an unexpected keyword argument '" + keyword + "'");
+        }
+        plan.keywordParams.push_back(param - params.begin());
+        bound[param - params.begin()] = true;
+    }
+    for (size_t i = site.positional; i < params.size(); i++) {
+        if (!bound[i]) {
+            plan.unbound.push_back(i);
+        }
+    }
+    plan.callee = &callee;
+    return plan;
+}
+
+CodeObject* VirtualMachine::codeFor(const FunctionCode& function, const Value* window) {
+    // Calls passing ints where the def's int version assumes them run that
+    // version
+    if (function.intCode && std::all_of(function.intParams.begin(), function.intParams.end(),
+                                        [&](uint32_t param) { return window[param].type == ValueType::INT; })) {
+        return function.intCode;
+    }
+    return function.code;
+}
+
+std::string VirtualMachine::formatValues(const Value* values, size_t count) {
+    std::string result;
+    for (size_t j = 0; j < count; j++) {
+        if (j > 0) result += ", ";
+
+        // For format strings, bool should be printed as True/False
+        if (values[j].type == ValueType::BOOL) {
+            result += values[j].boolVal ? "True" : "False";
+        } else if (values[j].type == ValueType::STRING) {
+            result += values[j].strVal;
+        } else {
+            result += values[j].toString();
+        }
+    }
+    return result;
+}
+
+void VirtualMachine::printValue(const Value& v) {
+    if (v.type == ValueType::STRING) {
+        std::cout << v.strVal;
+    } else {
+        std::cout << v.toString();
+    }
+}
+
+Value VirtualMachine::callBuiltinFunction(Builtin builtin, const std::string& name, const Value* args, size_t count) {
+    FunctionProfiler::Call profiled(name);
+    if (builtin == Builtin::PRINT) {
+        RuntimeStats::Scope output(RuntimeStats::OUTPUT);
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0) std::cout << " ";
+            printValue(args[i]);
+        }
+        std::cout << std::endl;
+        return Value::None();
+    } else if (builtin == Builtin::INT) {
+        if (count > 0) {
+            return convertToInt(args[0]);
+        }
+    } else if (builtin == Builtin::FLOAT) {
+        if (count > 0) {
+            return convertToFloat(args[0]);
+        }
+    } else if (builtin == Builtin::STR) {
+        if (count > 0) {
+            return convertToStr(args[0]);
+        }
+    } else if (builtin == Builtin::BOOL) {
+        if (count > 0) {
+            return convertToBool(args[0]);
+        }
+    }
+    return Value::None();
+}
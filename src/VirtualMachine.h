@@ -0,0 +1,110 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_VIRTUALMACHINE_H
+#define PYTHON_INTERPRETER_VIRTUALMACHINE_H
+
+#include "Bytecode.h"
+#include "Jit.h"
+#include "MemoCache.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Runs a compiled Program. Dispatch is direct-threaded where the compiler
+// supports labels as values (each instruction carries its handler's
+// address), with a switch over the opcode elsewhere. Each call gets a window
+// of registers, its parameters first; a call's arguments are evaluated into
+// the caller's registers where the callee's window will start, so binding
+// positional arguments moves nothing. Calls push a Frame rather than
+// recursing in C++, and a def's tail call of itself reuses its frame.
+// Operator instructions rewrite themselves to type-specialized forms the
+// first time they run, and a call of a name to a direct call of the builtin
+// or def it names. A call that passes ints where a def's
+// int-specialized version expects them runs that version, and with
+// --memoize, calls of pure defs return the result of an earlier call with
+// the same arguments when their cache has it. Hot while loops of small int
+// code are handed to the Jit.
+class VirtualMachine {
+public:
+    explicit VirtualMachine(Program& program) : program(program) {}
+
+    void run();
+
+private:
+    struct FunctionDef {
+        const FunctionCode* code = nullptr;
+        std::vector<Value> defaults;
+        MemoCache memo;
+    };
+
+    struct Frame {
+        const FunctionCode* function;
+        // Start of the call's window in registers
+        size_t base;
+        // Where the caller continues, and its operand that receives the result
+        CodeObject* callerCode;
+        Instruction* returnTo;
+        size_t callerBase;
+        uint32_t result;
+        // Whether the result goes to the callee's memo cache, under the
+        // arguments on top of memoKeys
+        bool memoized;
+    };
+
+    // How a call site's arguments bind to one def's parameters
+    struct BindingPlan {
+        const FunctionCode* callee = nullptr;
+        // Per keyword argument, the parameter it binds
+        std::vector<uint32_t> keywordParams;
+        // Parameters after the positional ones that no keyword binds
+        std::vector<uint32_t> unbound;
+    };
+
+    struct MemoKey {
+        MemoCache* cache;
+        std::vector<Value> arguments;
+        size_t hash;
+    };
+
+    Program& program;
+    std::vector<Value> globals;
+    // Per name, how many running calls have a parameter by that name; a
+    // LOAD_DYNAMIC of a name no call shadows reads the global directly
+    std::vector<uint32_t> shadowing;
+    std::vector<Frame> frames;
+    std::vector<MemoKey> memoKeys;
+    // Indexed by CallSite::plan
+    std::vector<BindingPlan> plans;
+    // Keyword arguments on their way to their parameters' registers
+    std::vector<Value> staged;
+    // Per name, the def bound to it (with null code when none is) and the
+    // builtin it names. A def run again replaces its slot's contents, so
+    // call sites that hold the slot call the new def.
+    std::vector<FunctionDef> functions;
+    std::vector<Builtin> builtins;
+    // Index of each name in globalNames, for calls of a name known only at
+    // run time
+    std::unordered_map<std::string, uint32_t> globalIndices;
+    std::vector<Value> registers;
+    Jit jit;
+
+    // Variable globalNames[name] as the running call sees it: the innermost
+    // call's parameter of that name, or else the global
+    Value& variable(uint32_t name);
+
+    void assign(const std::vector<std::vector<uint32_t>>& targets, Value* window, Value* values, size_t count);
+    // Binds a call's arguments to the parameters in window, where the
+    // positional ones already are; keywords holds the keyword arguments'
+    // values, which a call keeps right after the positional ones
+    void bindArguments(const FunctionDef& function, CallSite& site, Value* window, Value* keywords);
+    // The site's plan for calling callee, made the first time the site
+    // calls it
+    const BindingPlan& planFor(CallSite& site, const FunctionCode& callee);
+    // The version of function's code a call with these bound arguments runs
+    static CodeObject* codeFor(const FunctionCode& function, const Value* window);
+
+    static std::string formatValues(const Value* values, size_t count);
+    static void printValue(const Value& v);
+    static Value callBuiltinFunction(Builtin builtin, const std::string& name, const Value* args, size_t count);
+};
+
+#endif//PYTHON_INTERPRETER_VIRTUALMACHINE_H